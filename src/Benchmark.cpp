@@ -0,0 +1,760 @@
+#include <iostream>
+#include <array>
+#include <vector>
+#include <string>
+#include <chrono>
+#include <cstdlib>
+#include <cstdint>
+#include <algorithm>
+#include <set>
+
+#include <thread>
+#include <sstream>
+
+#include "Board.h"
+#include "Pentago.h"
+#include "RunTracker.h"
+#include "MinimaxComputerController.h"
+#include "RandomComputerController.h"
+
+//Micro benchmarks for the board primitives. Run with no arguments to run all
+//of them, or pass the names of the benchmarks to run.
+
+typedef std::chrono::steady_clock BenchClock;
+
+static const int BOARD_SAMPLES = 4096;
+
+double elapsed_seconds(BenchClock::time_point start)
+{
+    return std::chrono::duration<double>(BenchClock::now() - start).count();
+}
+
+void report(const std::string& name, double seconds, long long operations)
+{
+    std::cout << name << ": " << seconds * 1e9 / operations << " ns/op, "
+        << operations / seconds / 1e6 << " Mop/s" << std::endl;
+}
+
+//Build a set of random, partially filled boards.
+std::vector<Board> random_boards(int count)
+{
+    std::vector<Board> boards;
+    boards.reserve(count);
+
+    for(int i = 0; i < count; ++i) {
+        Board board;
+        int stones = std::rand() % (Board::TOTAL_ENTRIES+1);
+        for(int j = 0; j < stones; ++j) {
+            int cell = std::rand() % board.cell_count();
+            int entry = std::rand() % board.entries_per_cell();
+            board.set_value(cell, entry, (j % 2 == 0) ? WhiteEntry : BlackEntry);
+        }
+        boards.push_back(board);
+    }
+    return boards;
+}
+
+//The original array based board twist, kept as the baseline to compare
+//the table driven Board::rotate_cell against.
+struct ArrayBoard
+{
+    static const int SIZE = Board::CELL_SIZE*Board::CELLS_PER_ROW;
+    std::array<BoardEntry, Board::TOTAL_ENTRIES> entries;
+
+    explicit ArrayBoard(const Board& board) {
+        for(int y = 0; y < SIZE; ++y) {
+            for(int x = 0; x < SIZE; ++x) {
+                entries[x + y*SIZE] = board.get_value_absolute(x, y);
+            }
+        }
+    }
+
+    void rotate_cell(int cell, RotationDirection dir) {
+        const int cell_size = Board::CELL_SIZE;
+        std::array<BoardEntry, Board::CELL_ENTRIES> cell_copy;
+
+        int cell_start_x = (cell % Board::CELLS_PER_ROW) * cell_size;
+        int cell_start_y = (cell / Board::CELLS_PER_ROW) * cell_size;
+
+        for(int y = 0; y < cell_size; ++y) {
+            for(int x = 0; x < cell_size; ++x) {
+                cell_copy[x + y*cell_size] =
+                    entries[(x + cell_start_x) + (y + cell_start_y)*SIZE];
+            }
+        }
+
+        for(int y = 0; y < cell_size; ++y) {
+            for(int x = 0; x < cell_size; ++x) {
+                int rotated_x;
+                int rotated_y;
+                if(dir == RotateLeft) {
+                    rotated_y = (cell_size-1)-x;
+                    rotated_x = y;
+                } else {
+                    rotated_y = x;
+                    rotated_x = (cell_size-1)-y;
+                }
+                entries[(rotated_x + cell_start_x) + (rotated_y + cell_start_y)*SIZE] =
+                    cell_copy[x + y*cell_size];
+            }
+        }
+    }
+};
+
+void bench_rotation()
+{
+    const int ROUNDS = 2000;
+    std::vector<Board> boards = random_boards(BOARD_SAMPLES);
+    std::vector<ArrayBoard> array_boards;
+    for(const Board& board : boards) {
+        array_boards.push_back(ArrayBoard(board));
+    }
+
+    long long twists = 0;
+    long long checksum = 0;
+
+    BenchClock::time_point start = BenchClock::now();
+    for(int round = 0; round < ROUNDS; ++round) {
+        for(ArrayBoard& board : array_boards) {
+            board.rotate_cell(round % 4, (round & 4) ? RotateLeft : RotateRight);
+            twists += 1;
+        }
+    }
+    double array_time = elapsed_seconds(start);
+    for(const ArrayBoard& board : array_boards) {
+        checksum += board.entries[0];
+    }
+
+    start = BenchClock::now();
+    for(int round = 0; round < ROUNDS; ++round) {
+        for(Board& board : boards) {
+            board.rotate_cell(round % 4, (round & 4) ? RotateLeft : RotateRight);
+        }
+    }
+    double table_time = elapsed_seconds(start);
+    for(const Board& board : boards) {
+        checksum += board.white_mask() & 1;
+    }
+
+    report("rotate_cell (array loop)", array_time, twists);
+    report("rotate_cell (table)", table_time, twists);
+    std::cout << "speedup: " << array_time / table_time << "x"
+        << " (checksum " << checksum << ")" << std::endl;
+}
+
+void bench_batch_wins()
+{
+    const int ROUNDS = 500;
+    std::vector<Board> boards = random_boards(BOARD_SAMPLES);
+    std::vector<Board::Mask> white;
+    std::vector<Board::Mask> black;
+    for(const Board& board : boards) {
+        white.push_back(board.white_mask());
+        black.push_back(board.black_mask());
+    }
+    std::vector<WinStatus> single_results(boards.size());
+    std::vector<WinStatus> batch_results(boards.size());
+
+    long long evaluated = 0;
+
+    BenchClock::time_point start = BenchClock::now();
+    for(int round = 0; round < ROUNDS; ++round) {
+        for(int i = 0; i < BOARD_SAMPLES; ++i) {
+            single_results[i] = boards[i].check_for_wins();
+        }
+        evaluated += BOARD_SAMPLES;
+    }
+    double single_time = elapsed_seconds(start);
+
+    start = BenchClock::now();
+    for(int round = 0; round < ROUNDS; ++round) {
+        Board::check_for_wins_batch(white.data(), black.data(), BOARD_SAMPLES,
+                batch_results.data());
+    }
+    double batch_time = elapsed_seconds(start);
+
+    if(single_results != batch_results) {
+        std::cout << "batch results differ from check_for_wins!" << std::endl;
+    }
+
+    std::cout << "check_for_wins: " << evaluated / single_time / 1e6 << " M boards/s"
+        << std::endl;
+    std::cout << "check_for_wins_batch: " << evaluated / batch_time / 1e6 << " M boards/s"
+        << std::endl;
+    std::cout << "speedup: " << single_time / batch_time << "x" << std::endl;
+}
+
+//Check generate_distinct_moves against the positions reached by every legal
+//move, and compare the time taken by both generators.
+void bench_distinct_moves()
+{
+    const int ROUNDS = 100;
+    std::vector<Board> boards = random_boards(BOARD_SAMPLES);
+    boards[0] = Board();
+
+    long long generated = 0;
+    long long distinct = 0;
+    int mismatches = 0;
+    std::array<PackedMove, Board::MAX_MOVES> moves;
+    for(const Board& board : boards) {
+        for(PlayerColor color : {WhitePlayer, BlackPlayer}) {
+            std::set<std::pair<Board::Mask, Board::Mask>> children;
+            int count = board.generate_moves(moves.data());
+            for(int i = 0; i < count; ++i) {
+                Board child = board.clone();
+                child.apply_move_no_check(moves[i].to_move(), color);
+                children.insert(std::make_pair(child.white_mask(), child.black_mask()));
+            }
+
+            std::set<std::pair<Board::Mask, Board::Mask>> distinct_children;
+            count = board.generate_distinct_moves(color, moves.data());
+            for(int i = 0; i < count; ++i) {
+                Board child = board.clone();
+                child.apply_move_no_check(moves[i].to_move(), color);
+                distinct_children.insert(std::make_pair(child.white_mask(), child.black_mask()));
+            }
+
+            if(distinct_children != children || int(distinct_children.size()) != count) {
+                mismatches += 1;
+            }
+            generated += count;
+            distinct += children.size();
+        }
+    }
+    if(mismatches > 0) {
+        std::cout << "distinct moves differ from the children on " << mismatches
+            << " boards!" << std::endl;
+    }
+
+    long long checksum = 0;
+    long long all_moves = 0;
+    BenchClock::time_point start = BenchClock::now();
+    for(int round = 0; round < ROUNDS; ++round) {
+        for(const Board& board : boards) {
+            all_moves += board.generate_moves(moves.data());
+            checksum += moves[0].bits();
+        }
+    }
+    double all_time = elapsed_seconds(start);
+
+    long long distinct_moves = 0;
+    start = BenchClock::now();
+    for(int round = 0; round < ROUNDS; ++round) {
+        for(const Board& board : boards) {
+            distinct_moves += board.generate_distinct_moves(WhitePlayer, moves.data());
+            checksum += moves[0].bits();
+        }
+    }
+    double distinct_time = elapsed_seconds(start);
+
+    std::cout << "distinct moves: " << generated << " for " << distinct
+        << " distinct children" << std::endl;
+    report("generate_moves", all_time, all_moves);
+    report("generate_distinct_moves", distinct_time, distinct_moves);
+    std::cout << "(checksum " << checksum << ")" << std::endl;
+}
+
+//The original cell by cell run scan of the minimax evaluation, kept as the
+//baseline to compare the line pattern tables of RunTracker against.
+static bool scan_compare(BoardEntry entry, BoardEntry scan_entry, int& run_len)
+{
+    if(scan_entry == EmptyEntry) {
+        return true;
+    } else if(entry == scan_entry) {
+        ++run_len;
+        return true;
+    } else {
+        return false;
+    }
+}
+
+static int horiz_scan(const Board& board, int x, int y, BoardEntry entry)
+{
+    int run_len = 0;
+    for(int x2 = x+1; x2 < board.board_size(); ++x2) {
+        if(!scan_compare(entry, board.get_value_absolute(x2, y), run_len)) {
+            break;
+        }
+        if(x2-x >= Board::WIN_SIZE-1) {
+            break;
+        }
+    }
+    return run_len;
+}
+
+static int vert_scan(const Board& board, int x, int y, BoardEntry entry)
+{
+    int run_len = 0;
+    for(int y2 = y+1; y2 < board.board_size(); ++y2) {
+        if(!scan_compare(entry, board.get_value_absolute(x, y2), run_len)) {
+            break;
+        }
+        if(y2-y >= Board::WIN_SIZE-1) {
+            break;
+        }
+    }
+    return run_len;
+}
+
+static int diag_scan(const Board& board, int x, int y, BoardEntry entry)
+{
+    int run_len = 0;
+    int max_run = std::min(board.board_size() - std::max(x, y), Board::WIN_SIZE);
+    for(int off = 1; off < max_run; ++off) {
+        if(!scan_compare(entry, board.get_value_absolute(x+off, y+off), run_len)) {
+            break;
+        }
+    }
+    return run_len;
+}
+
+static int diag_scan_neg(const Board& board, int x, int y, BoardEntry entry)
+{
+    int run_len = 0;
+    int max_run = std::min(std::min(board.board_size() - x, y + 1), Board::WIN_SIZE);
+    for(int off = 1; off < max_run; ++off) {
+        if(!scan_compare(entry, board.get_value_absolute(x+off, y-off), run_len)) {
+            break;
+        }
+    }
+    return run_len;
+}
+
+static void add_run(std::array<int, 3>& runs, int run_len)
+{
+    if(run_len > runs[0]) {
+        runs[2] = runs[1];
+        runs[1] = runs[0];
+        runs[0] = run_len;
+    } else if(run_len > runs[1]) {
+        runs[2] = runs[1];
+        runs[1] = run_len;
+    } else if(run_len > runs[2]) {
+        runs[2] = run_len;
+    }
+}
+
+//Top 3 runs of each color, indexed by PlayerColor.
+static void scan_runs(const Board& board, std::array<int, 3> (&runs)[2])
+{
+    runs[WhitePlayer].fill(0);
+    runs[BlackPlayer].fill(0);
+
+    int size = board.board_size();
+    for(int y = 0; y < size; ++y) {
+        for(int x = 0; x < size; ++x) {
+            BoardEntry entry = board.get_value_absolute(x, y);
+            if(entry == EmptyEntry) {
+                continue;
+            }
+
+            std::array<int, 3>& color_runs = runs[entry == WhiteEntry ? WhitePlayer : BlackPlayer];
+            if(x < size-1) {
+                add_run(color_runs, horiz_scan(board, x, y, entry));
+            }
+            if(y < size-1) {
+                add_run(color_runs, vert_scan(board, x, y, entry));
+            }
+            if(x < size-1 && y < size-1) {
+                add_run(color_runs, diag_scan(board, x, y, entry));
+            }
+            if(x < size-1 && y > 0) {
+                add_run(color_runs, diag_scan_neg(board, x, y, entry));
+            }
+        }
+    }
+}
+
+//Full evaluations of the runs by the scan and by the pattern tables, and
+//incremental updates of a RunTracker over a move and its undo.
+void bench_run_scores()
+{
+    const int ROUNDS = 200;
+    std::vector<Board> boards = random_boards(BOARD_SAMPLES);
+
+    long long evaluated = 0;
+    long long checksum = 0;
+
+    std::vector<std::array<int, 3>> scan_results(2*BOARD_SAMPLES);
+    BenchClock::time_point start = BenchClock::now();
+    for(int round = 0; round < ROUNDS; ++round) {
+        for(int i = 0; i < BOARD_SAMPLES; ++i) {
+            std::array<int, 3> runs[2];
+            scan_runs(boards[i], runs);
+            scan_results[2*i] = runs[WhitePlayer];
+            scan_results[2*i+1] = runs[BlackPlayer];
+        }
+        evaluated += BOARD_SAMPLES;
+    }
+    double scan_time = elapsed_seconds(start);
+
+    std::vector<std::array<int, 3>> table_results(2*BOARD_SAMPLES);
+    start = BenchClock::now();
+    for(int round = 0; round < ROUNDS; ++round) {
+        for(int i = 0; i < BOARD_SAMPLES; ++i) {
+            RunTracker tracker(boards[i]);
+            tracker.best_runs(WhitePlayer, table_results[2*i].data(), 3);
+            tracker.best_runs(BlackPlayer, table_results[2*i+1].data(), 3);
+        }
+    }
+    double table_time = elapsed_seconds(start);
+
+    if(scan_results != table_results) {
+        std::cout << "pattern table runs differ from the scan!" << std::endl;
+    }
+
+    //A move and its undo on each board, with the tracker following both.
+    std::vector<RunTracker> trackers;
+    std::vector<Move> moves;
+    for(const Board& board : boards) {
+        trackers.push_back(RunTracker(board));
+        Board::Mask empty = board.empty_mask();
+        int entry = std::rand() % Board::TOTAL_ENTRIES;
+        while(empty && !((empty >> entry) & 1)) {
+            entry = (entry + 1) % Board::TOTAL_ENTRIES;
+        }
+        moves.push_back(Move(entry / Board::CELL_ENTRIES, entry % Board::CELL_ENTRIES,
+                    std::rand() % Board::CELL_COUNT, (std::rand() % 2) ? RotateLeft : RotateRight));
+    }
+
+    long long updates = 0;
+    start = BenchClock::now();
+    for(int round = 0; round < ROUNDS; ++round) {
+        for(int i = 0; i < BOARD_SAMPLES; ++i) {
+            if(boards[i].empty_mask() == 0) {
+                continue;
+            }
+            boards[i].make_move(moves[i], WhitePlayer);
+            trackers[i].update(boards[i]);
+            boards[i].unmake_move(moves[i]);
+            trackers[i].update(boards[i]);
+            updates += 2;
+        }
+    }
+    double update_time = elapsed_seconds(start);
+    for(const RunTracker& tracker : trackers) {
+        int runs[3];
+        tracker.best_runs(WhitePlayer, runs, 3);
+        checksum += runs[0];
+    }
+
+    std::cout << "find_runs scan: " << evaluated / scan_time / 1e6 << " M boards/s" << std::endl;
+    std::cout << "pattern tables: " << evaluated / table_time / 1e6 << " M boards/s" << std::endl;
+    std::cout << "speedup: " << scan_time / table_time << "x" << std::endl;
+    report("incremental update", update_time, updates);
+    std::cout << "(checksum " << checksum << ")" << std::endl;
+}
+
+//The original selection of the top 3 runs of the minimax evaluation, for the
+//player owning player_entry. Runs are compared against the player's third
+//best run whatever their color, so the opponent's runs depend on the order
+//they are scanned in.
+static void insert_shift_down(int val, std::array<int, 3>& array)
+{
+    if(val > array[0]) {
+        array[2] = array[1];
+        array[1] = array[0];
+        array[0] = val;
+    } else if(val > array[1]) {
+        array[2] = array[1];
+        array[1] = val;
+    } else {
+        array[2] = val;
+    }
+}
+
+static void add_scored_run(std::array<int, 3>& player_runs, std::array<int, 3>& opponent_runs,
+        int run_len, BoardEntry entry, BoardEntry player_entry)
+{
+    if(run_len > player_runs[2]) {
+        insert_shift_down(run_len, entry == player_entry ? player_runs : opponent_runs);
+    }
+}
+
+static void scan_scored_runs(const Board& board, BoardEntry player_entry,
+        std::array<int, 3>& player_runs, std::array<int, 3>& opponent_runs)
+{
+    player_runs.fill(0);
+    opponent_runs.fill(0);
+
+    int size = board.board_size();
+    for(int y = 0; y < size; ++y) {
+        for(int x = 0; x < size-1; ++x) {
+            BoardEntry entry = board.get_value_absolute(x, y);
+            if(entry != EmptyEntry) {
+                add_scored_run(player_runs, opponent_runs, horiz_scan(board, x, y, entry),
+                        entry, player_entry);
+            }
+        }
+    }
+    for(int y = 0; y < size-1; ++y) {
+        for(int x = 0; x < size; ++x) {
+            BoardEntry entry = board.get_value_absolute(x, y);
+            if(entry != EmptyEntry) {
+                add_scored_run(player_runs, opponent_runs, vert_scan(board, x, y, entry),
+                        entry, player_entry);
+            }
+        }
+    }
+    for(int y = 0; y < size-1; ++y) {
+        for(int x = 0; x < size-1; ++x) {
+            BoardEntry entry = board.get_value_absolute(x, y);
+            if(entry != EmptyEntry) {
+                add_scored_run(player_runs, opponent_runs, diag_scan(board, x, y, entry),
+                        entry, player_entry);
+            }
+        }
+    }
+    for(int y = 1; y < size; ++y) {
+        for(int x = 0; x < size-1; ++x) {
+            BoardEntry entry = board.get_value_absolute(x, y);
+            if(entry != EmptyEntry) {
+                add_scored_run(player_runs, opponent_runs, diag_scan_neg(board, x, y, entry),
+                        entry, player_entry);
+            }
+        }
+    }
+}
+
+static void tracked_scored_runs(const RunTracker& tracker, BoardEntry player_entry,
+        std::array<int, 3>& player_runs, std::array<int, 3>& opponent_runs)
+{
+    tracker.scored_runs(player_entry == WhiteEntry ? WhitePlayer : BlackPlayer, player_runs,
+            opponent_runs);
+}
+
+//Check the runs the evaluation scores, as picked from a RunTracker, against
+//the original scan on random games, with moves made and taken back and the
+//tracker updated after each. Then time both.
+void bench_scored_runs()
+{
+    const int GAMES = 2000;
+    const int ROUNDS = 50;
+
+    std::vector<Board> positions;
+    long long checked = 0;
+    int mismatches = 0;
+    for(int game = 0; game < GAMES; ++game) {
+        Board board;
+        RunTracker tracker(board);
+        std::vector<Move> played;
+        PlayerColor mover = WhitePlayer;
+
+        while(board.empty_mask() != 0 && board.check_for_wins() == NoWin) {
+            if(!played.empty() && std::rand() % 4 == 0) {
+                board.unmake_move(played.back());
+                played.pop_back();
+                mover = opposing_color(mover);
+            } else {
+                std::array<PackedMove, Board::MAX_MOVES> moves;
+                int count = board.generate_moves(moves.data());
+                Move move = moves[std::rand() % count].to_move();
+                board.make_move(move, mover);
+                played.push_back(move);
+                mover = opposing_color(mover);
+            }
+            tracker.update(board);
+            positions.push_back(board);
+
+            for(BoardEntry player_entry : {WhiteEntry, BlackEntry}) {
+                std::array<int, 3> scan_runs[2];
+                std::array<int, 3> tracked_runs[2];
+                scan_scored_runs(board, player_entry, scan_runs[0], scan_runs[1]);
+                tracked_scored_runs(tracker, player_entry, tracked_runs[0], tracked_runs[1]);
+                if(scan_runs[0] != tracked_runs[0] || scan_runs[1] != tracked_runs[1]) {
+                    mismatches += 1;
+                }
+                checked += 1;
+            }
+        }
+    }
+    std::cout << "checked " << checked << " positions, " << mismatches << " mismatches"
+        << std::endl;
+
+    long long checksum = 0;
+    BenchClock::time_point start = BenchClock::now();
+    for(int round = 0; round < ROUNDS; ++round) {
+        for(const Board& board : positions) {
+            std::array<int, 3> runs[2];
+            scan_scored_runs(board, WhiteEntry, runs[0], runs[1]);
+            checksum += runs[1][2];
+        }
+    }
+    double scan_time = elapsed_seconds(start);
+
+    std::vector<RunTracker> trackers(positions.begin(), positions.end());
+    start = BenchClock::now();
+    for(int round = 0; round < ROUNDS; ++round) {
+        for(const RunTracker& tracker : trackers) {
+            std::array<int, 3> runs[2];
+            tracked_scored_runs(tracker, WhiteEntry, runs[0], runs[1]);
+            checksum += runs[1][2];
+        }
+    }
+    double tracked_time = elapsed_seconds(start);
+
+    long long evaluated = (long long)ROUNDS * positions.size();
+    report("scan", scan_time, evaluated);
+    report("tracker", tracked_time, evaluated);
+    std::cout << "(checksum " << checksum << ")" << std::endl;
+}
+
+//A fixed middle game position for the search benchmarks.
+Board search_position()
+{
+    Board board;
+    const int moves[][3] = {
+        {0, 4, WhiteEntry}, {3, 4, BlackEntry}, {1, 4, WhiteEntry}, {2, 4, BlackEntry},
+        {0, 0, WhiteEntry}, {1, 2, BlackEntry}, {2, 6, WhiteEntry}, {3, 8, BlackEntry},
+    };
+    for(const auto& move : moves) {
+        board.set_value(move[0], move[1], static_cast<BoardEntry>(move[2]));
+    }
+    return board;
+}
+
+//Search the same position for a fixed time with a growing number of threads,
+//in each parallel mode, and report the depth reached and the node rate.
+void bench_search_threads()
+{
+    const float TURN_TIME = 2.0;
+    const int MAX_DEPTH = 16;
+
+    int max_threads = std::max(1u, std::thread::hardware_concurrency());
+    Board board = search_position();
+    Pentago game(board, new RandomComputerController("a", WhitePlayer),
+            new RandomComputerController("b", BlackPlayer));
+
+    const MinimaxComputerController::ParallelMode modes[] = {
+        MinimaxComputerController::LazySmp,
+        MinimaxComputerController::YoungBrothersWait,
+    };
+    const char* mode_names[] = {"lazy smp", "young brothers wait"};
+
+    for(int mode = 0; mode < 2; ++mode) {
+        for(int threads = 1; threads <= max_threads; threads *= 2) {
+            MinimaxComputerController controller("bench", WhitePlayer, board, MAX_DEPTH,
+                    TURN_TIME, 64, threads, modes[mode]);
+
+            //The controller reports on every move; keep that out of the results.
+            std::ostringstream search_log;
+            std::streambuf* out = std::cout.rdbuf(search_log.rdbuf());
+            controller.make_move(board, game);
+            std::cout.rdbuf(out);
+
+            double node_rate = controller.last_node_evals() / controller.last_search_time();
+            std::cout << mode_names[mode] << ", " << threads << " threads: depth "
+                << controller.last_depth() << ", " << node_rate / 1e3 << " k nodes/s, "
+                << node_rate / threads / 1e3 << " k nodes/s per thread" << std::endl;
+        }
+    }
+}
+
+//The fewest killers that, added to before, give after: each one added shifts
+//out the oldest, so after is the newest of before followed by that many valid
+//moves. -1 if after cannot follow from before.
+static int killers_added(const std::vector<Move>& before, const std::vector<Move>& after)
+{
+    int count = int(before.size());
+    for(int added = 0; added <= count; ++added) {
+        bool follows = std::equal(before.begin() + added, before.end(), after.begin());
+        for(int i = count - added; i < count && follows; ++i) {
+            follows = !after[i].is_invalid();
+        }
+        if(follows) {
+            return added;
+        }
+    }
+    return -1;
+}
+
+//Play a game against random moves and check that the killers one search
+//leaves behind are still there when the next search starts: the killers the
+//next search ends with must follow from them. A search that starts from
+//empty killer tables fails wherever it adds fewer killers than it lost.
+void bench_kept_killers()
+{
+    const int MAX_DEPTH = 4;
+    const int SEARCHES = 10;
+
+    Board board = search_position();
+    Pentago game(board, new RandomComputerController("a", WhitePlayer),
+            new RandomComputerController("b", BlackPlayer));
+    MinimaxComputerController controller("bench", WhitePlayer, board, MAX_DEPTH, 60.0);
+    RandomComputerController opponent("random", BlackPlayer);
+
+    std::vector<std::vector<Move>> last_killers;
+    int kept = 0;
+    int replaced = 0;
+    int lost = 0;
+    for(int search = 0; search < SEARCHES; ++search) {
+        std::ostringstream search_log;
+        std::streambuf* out = std::cout.rdbuf(search_log.rdbuf());
+        Move move = controller.make_move(board, game);
+        std::cout.rdbuf(out);
+
+        std::vector<std::vector<Move>> killers;
+        for(int depth_bound = 0; depth_bound < MAX_DEPTH; ++depth_bound) {
+            killers.push_back(controller.killers(depth_bound));
+        }
+        for(std::size_t i = 0; i < last_killers.size(); ++i) {
+            const std::vector<Move>& before = last_killers[i];
+            int added = killers_added(before, killers[i]);
+            if(added < 0) {
+                lost += 1;
+            } else if(std::any_of(before.begin() + added, before.end(),
+                        [](const Move& killer) {return !killer.is_invalid();})) {
+                kept += 1;
+            } else {
+                replaced += 1;
+            }
+        }
+        last_killers = killers;
+
+        if(board.apply_move(move, WhitePlayer) != NoWin || board.check_full()) {
+            break;
+        }
+        Move reply = opponent.make_move(board, game);
+        if(board.apply_move(reply, BlackPlayer) != NoWin || board.check_full()) {
+            break;
+        }
+    }
+
+    std::cout << "killer tables carried over " << kept << ", replaced " << replaced
+        << ", lost " << lost << std::endl;
+}
+
+struct Benchmark
+{
+    const char* name;
+    void (*run)();
+};
+
+static const Benchmark benchmarks[] = {
+    {"rotation", bench_rotation},
+    {"batch_wins", bench_batch_wins},
+    {"distinct_moves", bench_distinct_moves},
+    {"run_scores", bench_run_scores},
+    {"scored_runs", bench_scored_runs},
+    {"search_threads", bench_search_threads},
+    {"kept_killers", bench_kept_killers},
+};
+
+int main(int argc, char** argv)
+{
+    std::srand(1);
+
+    for(const Benchmark& benchmark : benchmarks) {
+        bool selected = (argc < 2);
+        for(int i = 1; i < argc; ++i) {
+            if(std::string(argv[i]) == benchmark.name) {
+                selected = true;
+            }
+        }
+        if(selected) {
+            std::cout << "== " << benchmark.name << " ==" << std::endl;
+            benchmark.run();
+        }
+    }
+    return 0;
+}
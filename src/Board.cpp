@@ -1,43 +1,53 @@
 #include "Board.h"
 
 #include <cassert>
+#include <algorithm>
+#include <stdexcept>
 
-RotationDirection reverse_direction(RotationDirection direction) {
-    if(direction == RotateLeft) {
-        return RotateRight;
-    } else {
-        return RotateLeft;
-    }
-}
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#include <immintrin.h>
+#define BOARD_AVX2_BATCH 1
+#endif
 
-void Board::set_value(int cell, int entry, BoardEntry value)
+template<int CellSize, int CellsPerRow, int WinSize>
+void BasicBoard<CellSize, CellsPerRow, WinSize>::set_value_absolute(int x, int y, BoardEntry value)
 {
-    int x;
-    int y; 
-
-    cell_to_absolute_pos(cell, entry, x, y);
+    int cell;
+    int entry;
+    absolute_pos_to_cell(x, y, cell, entry);
 
-    m_board[x + y*board_size()] = value;
-}
- 
-void Board::set_value_absolute(int x, int y, BoardEntry value)
-{
-    m_board[x + y*board_size()] = value;
+    set_value(cell, entry, value);
 }
  
-WinStatus Board::apply_move(const Move& move, PlayerColor color)
+template<int CellSize, int CellsPerRow, int WinSize>
+WinStatus BasicBoard<CellSize, CellsPerRow, WinSize>::apply_move(const Move& move, PlayerColor color)
 {
+    assert(check_for_wins() == NoWin);
+
+    const LineList& entry_lines = s_tables.entry_lines[entry_index(move.play_cell(), move.play_index())];
+    const LineList& cell_lines = s_tables.cell_lines[move.rotate_cell()];
+
     set_value(move.play_cell(), move.play_index(), player_color_to_board_entry(color));
-    bool no_twist_win = false;
 
-    WinStatus status = check_for_wins();
+    //Before the twist, only lines through the new piece can have been completed.
+    bool white_win = false;
+    bool black_win = false;
+    check_lines(entry_lines, white_win, black_win);
+    WinStatus status = win_status(white_win, black_win);
+
+    rotate_cell(move.rotate_cell(), move.rotation_direction()); 
+
+    //After it, lines through the twisted cell may also have changed.
+    white_win = false;
+    black_win = false;
+    check_lines(cell_lines, white_win, black_win);
     if(status != NoWin) {
-        no_twist_win = true;
+        check_lines(entry_lines, white_win, black_win);
     }
-    rotate_cell(move.rotate_cell(), move.rotation_direction()); 
-    WinStatus end_status = check_for_wins();
-    if(no_twist_win) {
-        if(check_for_wins() == Tie) {
+    WinStatus end_status = win_status(white_win, black_win);
+
+    if(status != NoWin) {
+        if(end_status == Tie) {
             return Tie;
         }
         else {
@@ -50,162 +60,591 @@ WinStatus Board::apply_move(const Move& move, PlayerColor color)
 }
  
  
-void Board::rotate_cell(int cell, RotationDirection dir)
+#ifdef BOARD_AVX2_BATCH
+//Test four positions per step, one per 64-bit lane, against every win line.
+//Bit 0 of wins[i] is set if position i has a white line and bit 1 if it has a
+//black line. Returns the number of positions handled, a multiple of four.
+//This lives outside the board template because GCC does not apply target
+//attributes to template members.
+__attribute__((target("avx2")))
+static int check_for_wins_avx2(const std::uint64_t* white, const std::uint64_t* black,
+        int count, const std::uint64_t* lines, int line_count, std::uint8_t* wins)
 {
-    std::array<BoardEntry, CELL_ENTRIES> cell_copy;
+    int i = 0;
+    for(; i + 4 <= count; i += 4) {
+        __m256i white_masks = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(white + i));
+        __m256i black_masks = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(black + i));
+        __m256i white_wins = _mm256_setzero_si256();
+        __m256i black_wins = _mm256_setzero_si256();
+
+        for(int line_index = 0; line_index < line_count; ++line_index) {
+            __m256i line = _mm256_set1_epi64x(lines[line_index]);
+            white_wins = _mm256_or_si256(white_wins,
+                    _mm256_cmpeq_epi64(_mm256_and_si256(white_masks, line), line));
+            black_wins = _mm256_or_si256(black_wins,
+                    _mm256_cmpeq_epi64(_mm256_and_si256(black_masks, line), line));
+        }
 
-    int cell_start_x;
-    int cell_start_y;
+        int white_lanes = _mm256_movemask_pd(_mm256_castsi256_pd(white_wins));
+        int black_lanes = _mm256_movemask_pd(_mm256_castsi256_pd(black_wins));
+        for(int lane = 0; lane < 4; ++lane) {
+            wins[i + lane] = ((white_lanes >> lane) & 1) | (((black_lanes >> lane) & 1) << 1);
+        }
+    }
+    return i;
+}
+#endif
 
-    cell_to_absolute_pos(cell, 0, cell_start_x, cell_start_y);
+template<int CellSize, int CellsPerRow, int WinSize>
+void BasicBoard<CellSize, CellsPerRow, WinSize>::check_for_wins_batch(const Mask* white, const Mask* black, int count,
+        WinStatus* results)
+{
+    int i = 0;
+#ifdef BOARD_AVX2_BATCH
+    //The vector path packs one 64-bit mask per lane.
+    if constexpr(sizeof(Mask) == sizeof(std::uint64_t)) {
+        static const bool has_avx2 = __builtin_cpu_supports("avx2");
+        if(has_avx2) {
+            const int BLOCK = 64;
+            std::uint8_t wins[BLOCK];
+            while(i + 4 <= count) {
+                int block = std::min(BLOCK, count - i);
+                int done = check_for_wins_avx2(white + i, black + i, block,
+                        s_tables.win_lines, WIN_LINE_COUNT, wins);
+                for(int j = 0; j < done; ++j) {
+                    results[i + j] = win_status(wins[j] & 1, wins[j] & 2);
+                }
+                i += done;
+            }
+        }
+    }
+#endif
+    for(; i < count; ++i) {
+        results[i] = check_masks(white[i], black[i]);
+    }
+}
 
-    for(int y = 0; y < cell_size(); ++y) {
-        int y_pos = y + cell_start_y;
-        for(int x = 0; x < cell_size(); ++x) {
-           int x_pos = x + cell_start_x;
-            
-           cell_copy[x + y*cell_size()] = m_board[x_pos + y_pos*board_size()];
+//A move wins if the stone completes a line before the twist, unless the twist
+//then leaves lines of both colors (a tie), or if it completes a line after the
+//twist and the opponent has none. Both are found from the lines missing a
+//single entry, so no move is ever applied.
+template<int CellSize, int CellsPerRow, int WinSize>
+int BasicBoard<CellSize, CellsPerRow, WinSize>::winning_moves(Mask own, Mask opp,
+        PackedMove* moves, int limit)
+{
+    Mask empty = ~(own | opp) & FULL_MASK;
+
+    //Entries that complete a line as soon as they are played, over all lines
+    //and over the lines clear of each cell, which no twist of that cell breaks.
+    Mask place_wins = 0;
+    Mask place_wins_clear[CELL_COUNT] = {};
+    for(int i = 0; i < WIN_LINE_COUNT; ++i) {
+        Mask line = s_tables.win_lines[i];
+        Mask missing = line & ~own;
+        if(!(missing & empty) || (missing & (missing - 1))) {
+            continue;
         }
-    } 
+        place_wins |= missing;
+        for(int cell = 0; cell < CELL_COUNT; ++cell) {
+            if(!(line & (CELL_MASK << (cell*CELL_ENTRIES)))) {
+                place_wins_clear[cell] |= missing;
+            }
+        }
+    }
+
+    //Winning entries for every twist. Only lines through the twisted cell can
+    //be completed or broken by it.
+    Mask wins[CELL_COUNT][2];
+    Mask any_wins = 0;
+    for(int cell = 0; cell < CELL_COUNT; ++cell) {
+        int shift = cell*CELL_ENTRIES;
+        const LineList& cell_lines = s_tables.cell_lines[cell];
+
+        for(int dir = RotateLeft; dir <= RotateRight; ++dir) {
+            Mask own_rotated = rotate_mask(own, cell, RotationDirection(dir));
+            Mask opp_rotated = rotate_mask(opp, cell, RotationDirection(dir));
+
+            bool own_line = false;
+            bool opp_line = false;
+            Mask completing = 0;
+            for(int i = 0; i < cell_lines.count; ++i) {
+                Mask line = s_tables.win_lines[cell_lines.lines[i]];
+                Mask missing = line & ~own_rotated;
+                if(!missing) {
+                    own_line = true;
+                } else if(!(missing & (missing - 1)) && !(missing & opp_rotated)) {
+                    completing |= missing;
+                }
+                opp_line |= (opp_rotated & line) == line;
+            }
 
-    for(int y = 0; y < cell_size(); ++y) {
+            //Completing entries inside the cell are played before the twist
+            //moves them, so map them back through the opposite twist.
+            Mask completing_cell = (completing >> shift) & CELL_MASK;
+            completing = (completing & ~(CELL_MASK << shift)) |
+                (Mask(s_tables.rotation[reverse_direction(RotationDirection(dir))][completing_cell]) << shift);
 
-        for(int x = 0; x < cell_size(); ++x) {
+            Mask own_after = own_line ? empty : (completing & empty);
+            if(opp_line) {
+                own_after |= place_wins_clear[cell];
+                wins[cell][dir] = place_wins & ~own_after;
+            } else {
+                wins[cell][dir] = place_wins | own_after;
+            }
+            any_wins |= wins[cell][dir];
+        }
+    }
 
-           int rotated_x;
-           int rotated_y;
+    int count = 0;
+    while(any_wins && count < limit) {
+        int index = lowest_entry(any_wins);
+        Mask bit = any_wins & -any_wins;
+        any_wins &= any_wins - 1;
+
+        int cell = s_tables.entry_cell[index];
+        int entry = s_tables.entry_offset[index];
+        for(int rot_cell = 0; rot_cell < CELL_COUNT && count < limit; ++rot_cell) {
+            if(wins[rot_cell][RotateLeft] & bit) {
+                moves[count++] = PackedMove(cell, entry, rot_cell, RotateLeft);
+            }
+            if((wins[rot_cell][RotateRight] & bit) && count < limit) {
+                moves[count++] = PackedMove(cell, entry, rot_cell, RotateRight);
+            }
+        }
+    }
+    return count;
+}
+
+//Rotate the CELL_ENTRIES bits of a single cell, laid out row-major.
+template<int CellSize, int CellsPerRow, int WinSize>
+constexpr typename BasicBoard<CellSize, CellsPerRow, WinSize>::Mask BasicBoard<CellSize, CellsPerRow, WinSize>::rotate_cell_bits(Mask cell_bits, RotationDirection dir)
+{
+    Mask rotated = 0;
+
+    for(int y = 0; y < CELL_SIZE; ++y) {
+        for(int x = 0; x < CELL_SIZE; ++x) {
+           if(!(cell_bits & (Mask(1) << (x + y*CELL_SIZE)))) {
+               continue;
+           }
+
+           int rotated_x = 0;
+           int rotated_y = 0;
             
            if(dir == RotateLeft) {
-               rotated_y = (cell_size()-1)-x;
+               rotated_y = (CELL_SIZE-1)-x;
                rotated_x = y;
-           } else if (dir == RotateRight) {
-               rotated_y = x;
-               rotated_x = (cell_size()-1)-y;
            } else {
-               assert(false);
-               return;
+               rotated_y = x;
+               rotated_x = (CELL_SIZE-1)-y;
            }
 
-           int x_pos_rotated = rotated_x + cell_start_x;
-           int y_pos_rotated = rotated_y + cell_start_y;
-           m_board[x_pos_rotated + y_pos_rotated*board_size()] = cell_copy[x + y*cell_size()];
+           rotated |= Mask(1) << (rotated_x + rotated_y*CELL_SIZE);
         }
     } 
+    return rotated;
 }
 
-WinStatus Board::check_for_wins() const
+//SplitMix64, used to generate a fixed set of Zobrist keys so hashes are
+//stable between runs.
+constexpr std::uint64_t next_zobrist_key(std::uint64_t& state)
 {
-    bool white_win = false;
-    bool black_win = false;
+    state += 0x9E3779B97F4A7C15ULL;
+    std::uint64_t z = state;
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    return z ^ (z >> 31);
+}
 
-    int run_len = 0;
-    BoardEntry run_type = EmptyEntry;
+template<int CellSize, int CellsPerRow, int WinSize>
+std::uint64_t BasicBoard<CellSize, CellsPerRow, WinSize>::compute_hash(Mask white, Mask black)
+{
+    std::uint64_t hash = 0;
+    for(int cell = 0; cell < CELLS_PER_ROW*CELLS_PER_ROW; ++cell) {
+        int shift = cell*CELL_ENTRIES;
+        hash ^= s_tables.cell_hash[cell][WhitePlayer][(white >> shift) & CELL_MASK];
+        hash ^= s_tables.cell_hash[cell][BlackPlayer][(black >> shift) & CELL_MASK];
+    }
+    return hash;
+}
 
-    //Look for horizontal wins 
-    for(int y = 0; y < board_size(); ++y) {
-        run_len = 0;
-        run_type = EmptyEntry;
+template<int CellSize, int CellsPerRow, int WinSize>
+std::uint64_t BasicBoard<CellSize, CellsPerRow, WinSize>::rank() const
+{
+    require_rankable();
+    std::uint64_t index = 0;
+    for(int cell = 0; cell < CELLS_PER_ROW*CELLS_PER_ROW; ++cell) {
+        int shift = cell*CELL_ENTRIES;
+        std::uint64_t cell_value = s_tables.ternary_pattern[(m_white >> shift) & CELL_MASK] +
+            2*s_tables.ternary_pattern[(m_black >> shift) & CELL_MASK];
+        index += cell_value * s_tables.cell_weight[cell];
+    }
+    return index;
+}
+
+template<int CellSize, int CellsPerRow, int WinSize>
+BasicBoard<CellSize, CellsPerRow, WinSize> BasicBoard<CellSize, CellsPerRow, WinSize>::unrank(std::uint64_t index)
+{
+    require_rankable();
+    Mask white = 0;
+    Mask black = 0;
+
+    for(int cell = 0; cell < CELLS_PER_ROW*CELLS_PER_ROW; ++cell) {
+        int cell_value = index % CELL_VALUES;
+        index /= CELL_VALUES;
 
-        for(int x = 0; x < board_size(); ++x) {
-            check_run_next(x, y, run_len, run_type, white_win, black_win);
+        for(int row = 0; row < CELL_SIZE; ++row) {
+            std::uint16_t row_bits = s_tables.row_decode[cell_value % ROW_VALUES];
+            cell_value /= ROW_VALUES;
+
+            int shift = cell*CELL_ENTRIES + row*CELL_SIZE;
+            white |= Mask(row_bits & 0xFF) << shift;
+            black |= Mask(row_bits >> 8) << shift;
         }
     }
+    return BasicBoard(white, black);
+}
 
-    //Look for vertical wins
-    for(int x = 0; x < board_size(); ++x) {
-        run_len = 0;
-        run_type = EmptyEntry;
+template<int CellSize, int CellsPerRow, int WinSize>
+void BasicBoard<CellSize, CellsPerRow, WinSize>::require_rankable()
+{
+    if(!RANKABLE) {
+        throw std::logic_error("board is too large to rank");
+    }
+}
 
-        for(int y = 0; y < board_size(); ++y) {
-            check_run_next(x, y, run_len, run_type, white_win, black_win);
-        }
+//Colex rank of a set of entries among all sets of the same size.
+template<int CellSize, int CellsPerRow, int WinSize>
+std::uint64_t BasicBoard<CellSize, CellsPerRow, WinSize>::combination_rank(Mask subset)
+{
+    std::uint64_t index = 0;
+    int count = 0;
+    while(subset) {
+        int entry = lowest_entry(subset);
+        subset &= subset - 1;
+        count += 1;
+        index += s_tables.binomial[entry][count];
     }
+    return index;
+}
 
-    for(int y = 0; y < board_size(); ++y) {
-        for(int x = 0; x < board_size()-WIN_SIZE+1; ++x) {
-            run_len = 0;
-            run_type = EmptyEntry;
-            for(int off = 0; off < board_size()-x; ++off) {
-                check_run_next(x+off, y+off, run_len, run_type, white_win, black_win);
-            } 
-        }
+template<int CellSize, int CellsPerRow, int WinSize>
+typename BasicBoard<CellSize, CellsPerRow, WinSize>::Mask BasicBoard<CellSize, CellsPerRow, WinSize>::combination_unrank(int count, std::uint64_t index)
+{
+    Mask subset = 0;
+    int entry = TOTAL_ENTRIES;
+    for(; count > 0; --count) {
+        do {
+            entry -= 1;
+        } while(s_tables.binomial[entry][count] > index);
+
+        subset |= Mask(1) << entry;
+        index -= s_tables.binomial[entry][count];
     }
+    return subset;
+}
 
-    for(int y = board_size()-2; y < board_size(); ++y) {
-        for(int x = 0; x < board_size()-WIN_SIZE+1; ++x) {
-            run_len = 0;
-            run_type = EmptyEntry;
-            for(int off = 0; off < board_size()-x; ++off) {
-                check_run_next(x+off, y-off, run_len, run_type, white_win, black_win);
-            } 
+//A slice index combines the rank of the set of occupied entries with the rank
+//of the white stones among the occupied entries.
+template<int CellSize, int CellsPerRow, int WinSize>
+std::uint64_t BasicBoard<CellSize, CellsPerRow, WinSize>::slice_rank() const
+{
+    require_rankable();
+    Mask occupied = occupied_mask();
+    int stones = count_entries(occupied);
+    int white_count = count_entries(m_white);
+
+    //Number the white stones by their position among the occupied entries.
+    Mask relative_white = 0;
+    Mask white = m_white;
+    while(white) {
+        Mask bit = white & -white;
+        white &= white - 1;
+        relative_white |= Mask(1) << count_entries(occupied & (bit - 1));
+    }
+
+    return combination_rank(occupied) * s_tables.binomial[stones][white_count] +
+        combination_rank(relative_white);
+}
+
+template<int CellSize, int CellsPerRow, int WinSize>
+BasicBoard<CellSize, CellsPerRow, WinSize> BasicBoard<CellSize, CellsPerRow, WinSize>::slice_unrank(int white_count, int black_count, std::uint64_t index)
+{
+    require_rankable();
+    int stones = white_count + black_count;
+    std::uint64_t white_choices = s_tables.binomial[stones][white_count];
+
+    Mask occupied = combination_unrank(stones, index / white_choices);
+    Mask relative_white = combination_unrank(white_count, index % white_choices);
+
+    Mask white = 0;
+    Mask remaining = occupied;
+    for(int i = 0; remaining; ++i) {
+        Mask bit = remaining & -remaining;
+        remaining &= remaining - 1;
+        if(relative_white & (Mask(1) << i)) {
+            white |= bit;
         }
     }
+    return BasicBoard(white, occupied & ~white);
+}
 
+template<int CellSize, int CellsPerRow, int WinSize>
+std::uint64_t BasicBoard<CellSize, CellsPerRow, WinSize>::slice_size(int white_count, int black_count)
+{
+    require_rankable();
+    int stones = white_count + black_count;
+    return s_tables.binomial[TOTAL_ENTRIES][stones] * s_tables.binomial[stones][white_count];
+}
 
-    /*
-    //Look for x diagonal wins
-    for(int x = 0; x < board_size()-WIN_SIZE+1; ++x) {
-        run_len = 0;
-        run_type = EmptyEntry;
-        for(int off = 0; off < board_size()-x; ++off) {
-            check_run_next(x+off, off, run_len, run_type, white_win, black_win);
-        } 
+//Map the position (x, y) on a size x size grid through a symmetry.
+template<int CellSize, int CellsPerRow, int WinSize>
+constexpr void BasicBoard<CellSize, CellsPerRow, WinSize>::apply_symmetry(int symmetry, int size, int& x, int& y)
+{
+    if(symmetry & 4) {
+        x = (size-1) - x;
     }
-    
-    //Look for y diagonal wins
-    for(int y = 0; y < board_size()-WIN_SIZE+1; ++y) {
-        run_len = 0;
-        run_type = EmptyEntry;
-        for(int off = 0; off < board_size()-y; ++off) {
-            check_run_next(off, y+off, run_len, run_type, white_win, black_win);
-        } 
+    for(int i = 0; i < (symmetry & 3); ++i) {
+        int rotated_x = (size-1) - y;
+        y = x;
+        x = rotated_x;
     }
-    */
+}
+
+template<int CellSize, int CellsPerRow, int WinSize>
+BasicBoard<CellSize, CellsPerRow, WinSize> BasicBoard<CellSize, CellsPerRow, WinSize>::transformed(int symmetry) const
+{
+    Mask white = 0;
+    Mask black = 0;
 
-    if(white_win && !black_win) {
-        return WhiteWin;
-    } else if(black_win && !white_win) {
-        return BlackWin;
-    } else if(black_win && white_win) {
-        return Tie;
-    } else {
-        return NoWin;
+    for(int cell = 0; cell < CELLS_PER_ROW*CELLS_PER_ROW; ++cell) {
+        int shift = cell*CELL_ENTRIES;
+        int new_shift = s_tables.symmetry_cell[symmetry][cell]*CELL_ENTRIES;
+        const std::uint16_t* patterns = s_tables.symmetry_pattern[symmetry];
+
+        white |= Mask(patterns[(m_white >> shift) & CELL_MASK]) << new_shift;
+        black |= Mask(patterns[(m_black >> shift) & CELL_MASK]) << new_shift;
     }
+    return BasicBoard(white, black);
 }
 
-bool Board::check_full() const
+template<int CellSize, int CellsPerRow, int WinSize>
+BasicBoard<CellSize, CellsPerRow, WinSize> BasicBoard<CellSize, CellsPerRow, WinSize>::canonical(int& symmetry) const
 {
-    for(int i = 0; i < board_size(); ++i) {
-        for(int j = 0; j < board_size(); ++j) {
-            if(get_value_absolute(i, j) == EmptyEntry) {
-                return false;
-            }
+    BasicBoard best = *this;
+    symmetry = 0;
+
+    for(int i = 1; i < SYMMETRY_COUNT; ++i) {
+        BasicBoard candidate = transformed(i);
+        if(candidate.m_white < best.m_white ||
+                (candidate.m_white == best.m_white && candidate.m_black < best.m_black)) {
+            best = candidate;
+            symmetry = i;
         }
     }
-    return true;
+    return best;
 }
- 
-void Board::check_run_next(int x, int y, int& run_len, BoardEntry& run_type,
-        bool& white_win, bool& black_win) const
+
+template<int CellSize, int CellsPerRow, int WinSize>
+std::uint64_t BasicBoard<CellSize, CellsPerRow, WinSize>::canonical_hash() const
 {
-        BoardEntry cell_value = get_value_absolute(x, y);
-        if(cell_value == run_type && run_type != EmptyEntry) {
-            run_len += 1;
-        } else {
-            run_len = 1;
-            run_type = cell_value;
+    int symmetry;
+    return canonical(symmetry).hash();
+}
+
+template<int CellSize, int CellsPerRow, int WinSize>
+Move BasicBoard<CellSize, CellsPerRow, WinSize>::transform_move(const Move& move, int symmetry)
+{
+    //Mirroring reverses the sense of a twist; rotating the board does not.
+    RotationDirection dir = move.rotation_direction();
+    if(symmetry & 4) {
+        dir = reverse_direction(dir);
+    }
+
+    return Move(s_tables.symmetry_cell[symmetry][move.play_cell()],
+            s_tables.symmetry_entry[symmetry][move.play_index()],
+            s_tables.symmetry_cell[symmetry][move.rotate_cell()], dir);
+}
+
+//Record a winning line in the line lists of every entry and cell it crosses.
+template<int CellSize, int CellsPerRow, int WinSize>
+constexpr void BasicBoard<CellSize, CellsPerRow, WinSize>::add_line(Tables& tables, int line_index, Mask line)
+{
+    for(int cell = 0; cell < CELL_COUNT; ++cell) {
+        if(line & (CELL_MASK << (cell*CELL_ENTRIES))) {
+            LineList& cell_lines = tables.cell_lines[cell];
+            cell_lines.lines[cell_lines.count++] = line_index;
+        }
+    }
+    for(int i = 0; i < TOTAL_ENTRIES; ++i) {
+        if(line & (Mask(1) << i)) {
+            LineList& entry_lines = tables.entry_lines[i];
+            entry_lines.lines[entry_lines.count++] = line_index;
+        }
+    }
+}
+
+//Build every lookup table. Only ever evaluated at compile time.
+template<int CellSize, int CellsPerRow, int WinSize>
+constexpr typename BasicBoard<CellSize, CellsPerRow, WinSize>::Tables BasicBoard<CellSize, CellsPerRow, WinSize>::build_tables()
+{
+    Tables tables = {};
+
+    for(int y = 0; y < BOARD_SIZE; ++y) {
+        for(int x = 0; x < BOARD_SIZE; ++x) {
+            int cell = (x / CELL_SIZE) + (y / CELL_SIZE) * CELLS_PER_ROW;
+            int entry = (x % CELL_SIZE) + (y % CELL_SIZE) * CELL_SIZE;
+            int index = entry_index(cell, entry);
+
+            tables.absolute_entry[x + y*BOARD_SIZE] = index;
+            tables.entry_x[index] = x;
+            tables.entry_y[index] = y;
+            tables.entry_cell[index] = cell;
+            tables.entry_offset[index] = entry;
+        }
+    }
+
+    for(int pattern = 0; pattern < CELL_PATTERNS; ++pattern) {
+        tables.rotation[RotateLeft][pattern] = rotate_cell_bits(pattern, RotateLeft);
+        tables.rotation[RotateRight][pattern] = rotate_cell_bits(pattern, RotateRight);
+    }
+    for(int pattern = 0; pattern < CELL_PATTERNS; ++pattern) {
+        int left = tables.rotation[RotateLeft][pattern];
+        int right = tables.rotation[RotateRight][pattern];
+        tables.twist_symmetry[pattern] = (left == pattern ? QUARTER_TWIST_SYMMETRIC : 0) |
+            (left == right ? HALF_TWIST_SYMMETRIC : 0);
+    }
+
+    std::uint64_t key_state = 0;
+    for(int cell = 0; cell < CELL_COUNT; ++cell) {
+        for(int color = 0; color < 2; ++color) {
+            std::uint64_t entry_keys[CELL_ENTRIES] = {};
+            for(int entry = 0; entry < CELL_ENTRIES; ++entry) {
+                entry_keys[entry] = next_zobrist_key(key_state);
+            }
+
+            for(int pattern = 0; pattern < CELL_PATTERNS; ++pattern) {
+                std::uint64_t key = 0;
+                for(int entry = 0; entry < CELL_ENTRIES; ++entry) {
+                    if(pattern & (1 << entry)) {
+                        key ^= entry_keys[entry];
+                    }
+                }
+                tables.cell_hash[cell][color][pattern] = key;
+            }
         }
-        if(run_len >= WIN_SIZE) {
-            if(run_type == WhiteEntry) {
-                white_win = true;
-            } else if(run_type == BlackEntry) {
-                black_win = true;
+    }
+
+    for(int symmetry = 0; symmetry < SYMMETRY_COUNT; ++symmetry) {
+        for(int cell = 0; cell < CELL_COUNT; ++cell) {
+            int x = cell % CELLS_PER_ROW;
+            int y = cell / CELLS_PER_ROW;
+            apply_symmetry(symmetry, CELLS_PER_ROW, x, y);
+            tables.symmetry_cell[symmetry][cell] = x + y*CELLS_PER_ROW;
+        }
+        for(int entry = 0; entry < CELL_ENTRIES; ++entry) {
+            int x = entry % CELL_SIZE;
+            int y = entry / CELL_SIZE;
+            apply_symmetry(symmetry, CELL_SIZE, x, y);
+            tables.symmetry_entry[symmetry][entry] = x + y*CELL_SIZE;
+        }
+        for(int pattern = 0; pattern < CELL_PATTERNS; ++pattern) {
+            int transformed = 0;
+            for(int entry = 0; entry < CELL_ENTRIES; ++entry) {
+                if(pattern & (1 << entry)) {
+                    transformed |= 1 << tables.symmetry_entry[symmetry][entry];
+                }
             }
+            tables.symmetry_pattern[symmetry][pattern] = transformed;
         }
+    }
+
+    //The inverse of a symmetry is the one that maps every entry back to itself.
+    for(int symmetry = 0; symmetry < SYMMETRY_COUNT; ++symmetry) {
+        for(int inverse = 0; inverse < SYMMETRY_COUNT; ++inverse) {
+            bool is_inverse = true;
+            for(int entry = 0; entry < CELL_ENTRIES; ++entry) {
+                if(tables.symmetry_entry[inverse][tables.symmetry_entry[symmetry][entry]] != entry) {
+                    is_inverse = false;
+                }
+            }
+            if(is_inverse) {
+                tables.inverse_symmetry[symmetry] = inverse;
+            }
+        }
+    }
+
+    for(int pattern = 0; pattern < CELL_PATTERNS; ++pattern) {
+        std::uint32_t value = 0;
+        for(int entry = CELL_ENTRIES-1; entry >= 0; --entry) {
+            value = value*3 + ((pattern >> entry) & 1);
+        }
+        tables.ternary_pattern[pattern] = value;
+    }
+    for(int cell = 0; cell < CELL_COUNT; ++cell) {
+        tables.cell_weight[cell] = power_of_three(cell*CELL_ENTRIES);
+    }
+    for(int value = 0; value < ROW_VALUES; ++value) {
+        int white = 0;
+        int black = 0;
+        int digits = value;
+        for(int entry = 0; entry < CELL_SIZE; ++entry) {
+            if(digits % 3 == 1) {
+                white |= 1 << entry;
+            } else if(digits % 3 == 2) {
+                black |= 1 << entry;
+            }
+            digits /= 3;
+        }
+        tables.row_decode[value] = white | (black << 8);
+    }
+    for(int n = 0; n <= TOTAL_ENTRIES; ++n) {
+        for(int k = 0; k <= TOTAL_ENTRIES; ++k) {
+            if(k == 0) {
+                tables.binomial[n][k] = 1;
+            } else if(n == 0) {
+                tables.binomial[n][k] = 0;
+            } else {
+                tables.binomial[n][k] = tables.binomial[n-1][k-1] + tables.binomial[n-1][k];
+            }
+        }
+    }
+
+    //Horizontal, vertical, diagonal and anti-diagonal runs of WIN_SIZE entries.
+    const int directions[4][2] = {{1, 0}, {0, 1}, {1, 1}, {1, -1}};
+    int line_count = 0;
+
+    for(int d = 0; d < 4; ++d) {
+        int dx = directions[d][0];
+        int dy = directions[d][1];
+
+        for(int y = 0; y < BOARD_SIZE; ++y) {
+            for(int x = 0; x < BOARD_SIZE; ++x) {
+                int end_x = x + dx*(WIN_SIZE-1);
+                int end_y = y + dy*(WIN_SIZE-1);
+                if(end_x < 0 || end_x >= BOARD_SIZE || end_y < 0 || end_y >= BOARD_SIZE) {
+                    continue;
+                }
+
+                Mask line = 0;
+                for(int i = 0; i < WIN_SIZE; ++i) {
+                    line |= Mask(1) << tables.absolute_entry[(x + dx*i) + (y + dy*i)*BOARD_SIZE];
+                }
+                tables.win_lines[line_count] = line;
+                add_line(tables, line_count, line);
+                line_count += 1;
+            }
+        }
+    }
+
+    return tables;
 }
- 
 
-void output_line_border(std::ostream& stream, const Board& board) {
+template<int CellSize, int CellsPerRow, int WinSize>
+constexpr typename BasicBoard<CellSize, CellsPerRow, WinSize>::Tables BasicBoard<CellSize, CellsPerRow, WinSize>::s_tables = build_tables();
+
+
+template<int CellSize, int CellsPerRow, int WinSize>
+void output_line_border(std::ostream& stream, const BasicBoard<CellSize, CellsPerRow, WinSize>& board) {
     stream << "+";
     for(int i = 0; i < board.cells_per_row(); ++i) {
         for(int j = 0; j < board.cell_size()*2-1; ++j) {
@@ -216,7 +655,8 @@ void output_line_border(std::ostream& stream, const Board& board) {
     stream << "\n";
 }
 
-void output_blank_line(std::ostream& stream, const Board& board) {
+template<int CellSize, int CellsPerRow, int WinSize>
+void output_blank_line(std::ostream& stream, const BasicBoard<CellSize, CellsPerRow, WinSize>& board) {
     for(int i = 0; i < board.board_size()*2; ++i) {
         if(i % (board.cell_size()*2) == 0) {
             stream << '|';
@@ -239,7 +679,8 @@ std::ostream& operator <<(std::ostream& stream, BoardEntry entry) {
     return stream;
 }
 
-std::ostream& operator <<(std::ostream& stream, const Board& board) {
+template<int CellSize, int CellsPerRow, int WinSize>
+std::ostream& operator <<(std::ostream& stream, const BasicBoard<CellSize, CellsPerRow, WinSize>& board) {
 
     for(int y = 0; y < board.board_size(); ++y) {
         if(y % board.cell_size() == 0) {
@@ -273,4 +714,9 @@ std::ostream& operator<<(std::ostream& stream, WinStatus value)
 
    return stream;
 }
- 
+
+template class BasicBoard<3, 2, 5>;
+template class BasicBoard<3, 3, 5>;
+
+template std::ostream& operator << <3, 2, 5>(std::ostream& stream, const Board& board);
+template std::ostream& operator << <3, 3, 5>(std::ostream& stream, const LargeBoard& board);
@@ -4,34 +4,72 @@
 #include <vector>
 #include <ostream>
 #include <array>
+#include <cstdint>
+#include <type_traits>
 
 #include "Enums.h"
 #include "Move.h"
 
+//3 to the power n, usable in constant expressions.
+constexpr std::uint64_t power_of_three(int n)
+{
+    return n == 0 ? 1 : 3*power_of_three(n-1);
+}
+
 //Object representing the state of a pentago board.
-class Board
+//
+//The position is stored as two bitboards, one per color. Bit
+//(cell*CELL_ENTRIES + entry) is set if that entry holds a stone of the
+//mask's color, so each cell occupies a contiguous group of CELL_ENTRIES bits.
+template<int CellSize, int CellsPerRow, int WinSize>
+class BasicBoard
 {
 public:
-    static const int WIN_SIZE = 5;
-    static const int CELL_SIZE = 3;
-    static const int CELLS_PER_ROW = 2;
-    static const int TOTAL_ENTRIES = CELL_SIZE*CELL_SIZE*CELLS_PER_ROW*CELLS_PER_ROW;
-    static const int CELL_ENTRIES = CELL_SIZE*CELL_SIZE;
+    static constexpr int WIN_SIZE = WinSize;
+    static constexpr int CELL_SIZE = CellSize;
+    static constexpr int CELLS_PER_ROW = CellsPerRow;
+    static constexpr int TOTAL_ENTRIES = CELL_SIZE*CELL_SIZE*CELLS_PER_ROW*CELLS_PER_ROW;
+    static constexpr int CELL_ENTRIES = CELL_SIZE*CELL_SIZE;
+    static constexpr int BOARD_SIZE = CELL_SIZE*CELLS_PER_ROW;
+
+    //Number of distinct WIN_SIZE runs along rows, columns and diagonals.
+    static constexpr int WIN_LINE_COUNT = 2*BOARD_SIZE*(BOARD_SIZE-WIN_SIZE+1) +
+        2*(BOARD_SIZE-WIN_SIZE+1)*(BOARD_SIZE-WIN_SIZE+1);
+
+    static constexpr int CELL_COUNT = CELLS_PER_ROW*CELLS_PER_ROW;
+
+    //One bit per entry. Boards of more than 64 entries use 128-bit masks.
+    typedef typename std::conditional<(TOTAL_ENTRIES <= 64), std::uint64_t,
+            unsigned __int128>::type Mask;
+
+    static constexpr int CELL_PATTERNS = 1 << CELL_ENTRIES;
+    static constexpr Mask CELL_MASK = CELL_PATTERNS - 1;
+    static constexpr Mask FULL_MASK = (Mask(1) << TOTAL_ENTRIES) - 1;
+
+    //Upper bound on the number of legal moves in any position.
+    static constexpr int MAX_MOVES = TOTAL_ENTRIES*CELLS_PER_ROW*CELLS_PER_ROW*2;
+
+    //The symmetries of the square board. Each one maps cells onto cells, so
+    //twists and win lines are preserved. Symmetry s mirrors left to right if
+    //s & 4, then rotates clockwise (s & 3) quarter turns. Symmetry 0 is the
+    //identity.
+    static constexpr int SYMMETRY_COUNT = 8;
 
-    //Construct a board with the given dimensions.
-    //Board(3, 2) is the standard 6x6 board.
-    Board();
-    ~Board() {};
+    //Construct an empty board. The dimensions are template parameters: the
+    //board has CellsPerRow x CellsPerRow cells of CellSize x CellSize entries,
+    //and WinSize in a row wins.
+    BasicBoard();
+    ~BasicBoard() {};
 
-    Board(const Board& other);
+    BasicBoard(const BasicBoard& other);
 
-    Board clone() const;
+    //Construct a board from a pair of color masks.
+    BasicBoard(Mask white, Mask black);
+
+    BasicBoard clone() const;
 
     //Get entry values
-    BoardEntry& get_value(int cell, int entry);
     BoardEntry get_value(int cell, int entry) const;
-
-    BoardEntry& get_value_absolute(int x, int y);
     BoardEntry get_value_absolute(int x, int y) const;
 
     bool is_cell_empty(int cell, int entry) const;
@@ -44,10 +82,50 @@ public:
     //the piece to the board but before twisting a cell,
     //the win status will be returned and the twist will not be
     //applied.
+    //Only lines through the played entry and the twisted cell are checked,
+    //so the board must not already contain a win.
     WinStatus apply_move(const Move& move, PlayerColor color);
 
     void apply_move_no_check(const Move& move, PlayerColor color);
 
+    //Apply a move in place without checking for wins. unmake_move undoes
+    //the most recent make_move of the same move, so a search can walk a single
+    //board instead of copying it for every child.
+    void make_move(const Move& move, PlayerColor color);
+    void unmake_move(const Move& move);
+    void make_move(PackedMove move, PlayerColor color);
+    void unmake_move(PackedMove move);
+
+    //Write every legal move to moves, which must hold MAX_MOVES entries, and
+    //return the number written. Moves are ordered by entry, then twist.
+    int generate_moves(PackedMove* moves) const;
+
+    //Write every move that wins on the spot for color, as apply_move would
+    //score it, to moves, which must hold MAX_MOVES entries, and return the
+    //number written. Moves are ordered by entry, then twist. Works on the color
+    //masks and the line tables alone, without applying any move. The board must
+    //not already contain a win.
+    int generate_winning_moves(PlayerColor color, PackedMove* moves) const;
+
+    //Twists that give distinct positions after color plays at (cell, entry).
+    //Bit rot_cell*2 + direction is set for each twist kept. Of the twists that
+    //leave a cell unchanged (an empty or fully symmetric cell) only the first
+    //is kept, and where both directions give the same cell only RotateLeft is.
+    //A twist is also dropped when a placement on a lower entry of the same
+    //cell reaches the same position, by twisting the cell or by a twist that
+    //leaves the board unchanged. Over all entries, every distinct position
+    //after a move is kept exactly once.
+    unsigned distinct_twists(int cell, int entry, PlayerColor color) const;
+
+    //Like generate_moves for color, but each distinct position reached by a
+    //move is generated only once, as described for distinct_twists.
+    int generate_distinct_moves(PlayerColor color, PackedMove* moves) const;
+    bool has_winning_move(PlayerColor color) const;
+
+    //The threats color must answer: every move with which the opponent would
+    //win if it were their turn.
+    int generate_threats(PlayerColor color, PackedMove* moves) const;
+
     //Return board dimensions
     int board_size() const {return CELL_SIZE*CELLS_PER_ROW;}
     int cells_per_row() const {return CELLS_PER_ROW;}
@@ -57,102 +135,582 @@ public:
     int total_entries() const {return TOTAL_ENTRIES;}
 
     void cell_to_absolute_pos(int cell, int entry, int& x, int& y) const;
+    void absolute_pos_to_cell(int x, int y, int& cell, int& entry) const;
+
+    //Bit index of an entry within the color masks.
+    static constexpr int entry_index(int cell, int entry) {return cell*CELL_ENTRIES + entry;}
+    static int absolute_index(int x, int y);
+
+    //Raw access to the color masks.
+    Mask white_mask() const {return m_white;}
+    Mask black_mask() const {return m_black;}
+    Mask player_mask(PlayerColor color) const;
+    Mask occupied_mask() const {return m_white | m_black;}
+    Mask empty_mask() const {return ~(m_white | m_black) & FULL_MASK;}
+
+    //Index of the lowest set bit, and number of set bits, of a mask.
+    static int lowest_entry(Mask mask);
+    static int count_entries(Mask mask);
 
     void rotate_cell(int cell, RotationDirection dir);
 
+    //Zobrist key of the position, maintained incrementally as entries are
+    //set and cells are twisted.
+    std::uint64_t hash() const {return m_hash;}
+
+    //Compute the Zobrist key of a position from scratch.
+    static std::uint64_t compute_hash(Mask white, Mask black);
+
+    //Perfect ranking of positions. rank() numbers every assignment of
+    //empty/white/black to the entries densely from 0 to RANK_COUNT-1, as the
+    //base 3 number with entry i as digit i. unrank() inverts it. Ranks only
+    //fit in 64 bits for boards of up to 40 entries; on larger boards
+    //RANKABLE is false and the ranking functions throw std::logic_error.
+    static constexpr bool RANKABLE = TOTAL_ENTRIES <= 40;
+    static constexpr std::uint64_t RANK_COUNT = RANKABLE ? power_of_three(TOTAL_ENTRIES) : 0;
+    std::uint64_t rank() const;
+    static BasicBoard unrank(std::uint64_t index);
+
+    //Ranking within a slice of positions that share the same number of white
+    //and black stones. Indices run densely from 0 to slice_size()-1.
+    std::uint64_t slice_rank() const;
+    static BasicBoard slice_unrank(int white_count, int black_count, std::uint64_t index);
+    static std::uint64_t slice_size(int white_count, int black_count);
+
+    //Return this board mapped through the given symmetry.
+    BasicBoard transformed(int symmetry) const;
+
+    //Return the canonical orientation of this board, the symmetric variant with
+    //the smallest masks, and set symmetry to the transform that maps this board
+    //onto it. Equivalent positions share a canonical form and canonical hash.
+    BasicBoard canonical(int& symmetry) const;
+    std::uint64_t canonical_hash() const;
+
+    //Map a move through a symmetry. A move on this board becomes the matching
+    //move on transformed(symmetry); inverse_symmetry maps it back.
+    static Move transform_move(const Move& move, int symmetry);
+    static int inverse_symmetry(int symmetry) {return s_tables.inverse_symmetry[symmetry];}
+
     //Check for victory/loss conditions.
     WinStatus check_for_wins() const;
-    bool check_full() const;
 
-    friend std::ostream& operator <<(std::ostream& stream, const Board& board);
+    //Check count positions at once, given as parallel arrays of white and
+    //black masks, writing the check_for_wins result of each to results. Uses
+    //AVX2 when the CPU supports it.
+    static void check_for_wins_batch(const Mask* white, const Mask* black, int count,
+            WinStatus* results);
+    bool check_full() const;
 
 protected:
 
-    std::array<BoardEntry, TOTAL_ENTRIES> m_board;
+    Mask m_white;
+    Mask m_black;
+    std::uint64_t m_hash;
 private:
 
-    void rotate_cell_left(int cell);
-    void rotate_cell_right(int cell);
+    static constexpr int CELL_VALUES = power_of_three(CELL_ENTRIES);
+    static constexpr int ROW_VALUES = power_of_three(CELL_SIZE);
+
+    static constexpr int QUARTER_TWIST_SYMMETRIC = 1;
+    static constexpr int HALF_TWIST_SYMMETRIC = 2;
+
+    //A set of winning lines, stored as indices into Tables::win_lines.
+    struct LineList
+    {
+        int count;
+        std::uint8_t lines[WIN_LINE_COUNT];
+    };
+
+    //Every lookup table the board uses. All of them are built at compile time
+    //by build_tables(), so nothing is computed on the hot path or at startup.
+    struct Tables
+    {
+        //Bit index of each absolute position (x + y*BOARD_SIZE), and the
+        //position, cell and entry of each bit index.
+        std::uint8_t absolute_entry[BOARD_SIZE*BOARD_SIZE];
+        std::uint8_t entry_x[TOTAL_ENTRIES];
+        std::uint8_t entry_y[TOTAL_ENTRIES];
+        std::uint8_t entry_cell[TOTAL_ENTRIES];
+        std::uint8_t entry_offset[TOTAL_ENTRIES];
+
+        //Rotated bit pattern of a single cell for every possible pattern of
+        //that cell, indexed by direction and then pattern.
+        std::uint16_t rotation[2][CELL_PATTERNS];
+
+        //Symmetry of each cell pattern under twists. QUARTER_TWIST_SYMMETRIC
+        //is set if a twist leaves the pattern unchanged, HALF_TWIST_SYMMETRIC if
+        //both directions give the same pattern.
+        std::uint8_t twist_symmetry[CELL_PATTERNS];
+
+        //Masks of every winning line on the board, and the winning lines
+        //passing through each entry and each cell.
+        Mask win_lines[WIN_LINE_COUNT];
+        LineList entry_lines[TOTAL_ENTRIES];
+        LineList cell_lines[CELL_COUNT];
+
+        //Zobrist contribution of every pattern of each cell, indexed by cell,
+        //then color and then pattern. The key of a single entry is the
+        //contribution of the pattern with only that entry set.
+        std::uint64_t cell_hash[CELL_COUNT][2][CELL_PATTERNS];
 
-    void check_run_next(int x, int y, int& run_len, BoardEntry& run_type, bool& white_win, bool& black_win) const;
+        //Symmetry tables. Each symmetry moves whole cells and transforms the
+        //entries within them the same way, so a board is transformed cell by
+        //cell.
+        std::uint8_t symmetry_cell[SYMMETRY_COUNT][CELL_COUNT];
+        std::uint8_t symmetry_entry[SYMMETRY_COUNT][CELL_ENTRIES];
+        std::uint16_t symmetry_pattern[SYMMETRY_COUNT][CELL_PATTERNS];
+        int inverse_symmetry[SYMMETRY_COUNT];
+
+        //Ranking tables. The base 3 value of a cell is
+        //ternary_pattern[white] + 2*ternary_pattern[black], the weight of each
+        //cell is 3^(cell*CELL_ENTRIES), and each of the 3^CELL_SIZE values of a
+        //row of a cell decodes to its white pattern in the low byte and black
+        //pattern in the high byte of row_decode.
+        std::uint32_t ternary_pattern[CELL_PATTERNS];
+        std::uint64_t cell_weight[CELL_COUNT];
+        std::uint16_t row_decode[ROW_VALUES];
+        std::uint64_t binomial[TOTAL_ENTRIES+1][TOTAL_ENTRIES+1];
+    };
+
+    static constexpr Tables build_tables();
+    static constexpr Mask rotate_cell_bits(Mask cell_bits, RotationDirection dir);
+    static constexpr void apply_symmetry(int symmetry, int size, int& x, int& y);
+    static constexpr void add_line(Tables& tables, int line_index, Mask line);
+
+    static const Tables s_tables;
+
+    static WinStatus win_status(bool white_win, bool black_win);
+    static WinStatus check_masks(Mask white, Mask black);
+    void check_lines(const LineList& lines, bool& white_win, bool& black_win) const;
+
+    //Apply a twist to a single color mask.
+    static Mask rotate_mask(Mask mask, int cell, RotationDirection dir);
+
+    //Whether the mover, with cell patterns own and other before moving, can
+    //leave the cell as (own_after, other_after) by playing on an entry of it
+    //below entry and then twisting it, or making a twist that changes nothing.
+    //unchanged_elsewhere tells whether another cell has such a twist.
+    static bool lower_entry_reaches(int own, int other, int entry, int own_after,
+            int other_after, bool unchanged_elsewhere);
+
+    //Write up to limit of the moves that win immediately for the player
+    //owning own, in generate_winning_moves order, and return the number
+    //written.
+    static int winning_moves(Mask own, Mask opp, PackedMove* moves, int limit);
+
+    static void require_rankable();
+    static std::uint64_t combination_rank(Mask subset);
+    static Mask combination_unrank(int count, std::uint64_t index);
 };
 
 std::ostream& operator <<(std::ostream& stream, BoardEntry entry);
 std::ostream& operator <<(std::ostream& stream, WinStatus value);
 
-//Functions inlined for considerable performance improvement
+template<int CellSize, int CellsPerRow, int WinSize>
+std::ostream& operator <<(std::ostream& stream, const BasicBoard<CellSize, CellsPerRow, WinSize>& board);
 
-inline BoardEntry& Board::get_value(int cell, int entry)
-{
-    int x;
-    int y;
-    cell_to_absolute_pos(cell, entry, x, y);
+//The standard 6x6 board of 3x3 cells.
+typedef BasicBoard<3, 2, 5> Board;
+//A 9x9 board of 3x3 cells.
+typedef BasicBoard<3, 3, 5> LargeBoard;
 
-    return m_board[x + y * board_size()];
+//Functions inlined for considerable performance improvement
 
-}
- 
-inline BoardEntry Board::get_value(int cell, int entry) const
+template<int CellSize, int CellsPerRow, int WinSize>
+inline BoardEntry BasicBoard<CellSize, CellsPerRow, WinSize>::get_value(int cell, int entry) const
 {
-    int x;
-    int y;
-    cell_to_absolute_pos(cell, entry, x, y);
+    Mask bit = Mask(1) << entry_index(cell, entry);
 
-    return m_board[x + y * board_size()];
+    if(m_white & bit) {
+        return WhiteEntry;
+    } else if(m_black & bit) {
+        return BlackEntry;
+    }
+    return EmptyEntry;
 }
  
-inline BoardEntry& Board::get_value_absolute(int x, int y)
+template<int CellSize, int CellsPerRow, int WinSize>
+inline BoardEntry BasicBoard<CellSize, CellsPerRow, WinSize>::get_value_absolute(int x, int y) const
 {
-    return m_board[x + y*board_size()]; 
+    Mask bit = Mask(1) << absolute_index(x, y);
+
+    if(m_white & bit) {
+        return WhiteEntry;
+    } else if(m_black & bit) {
+        return BlackEntry;
+    }
+    return EmptyEntry;
 }
  
-inline BoardEntry Board::get_value_absolute(int x, int y) const
+template<int CellSize, int CellsPerRow, int WinSize>
+inline bool BasicBoard<CellSize, CellsPerRow, WinSize>::is_cell_empty(int cell, int entry) const
 {
-    return m_board[x + y*board_size()]; 
+    return !(occupied_mask() & (Mask(1) << entry_index(cell, entry)));
 }
  
-inline bool Board::is_cell_empty(int cell, int entry) const
+template<int CellSize, int CellsPerRow, int WinSize>
+inline bool BasicBoard<CellSize, CellsPerRow, WinSize>::is_cell_empty_absolute(int x, int y) const
 {
-    return get_value(cell, entry) == EmptyEntry; 
+    return get_value_absolute(x, y) == EmptyEntry; 
 }
- 
-inline bool Board::is_cell_empty_absolute(int x, int y) const
+
+template<int CellSize, int CellsPerRow, int WinSize>
+inline void BasicBoard<CellSize, CellsPerRow, WinSize>::set_value(int cell, int entry, BoardEntry value)
 {
-    return get_value_absolute(x, y) == EmptyEntry; 
+    Mask bit = Mask(1) << entry_index(cell, entry);
+
+    if(m_white & bit) {
+        m_hash ^= s_tables.cell_hash[cell][WhitePlayer][1 << entry];
+    } else if(m_black & bit) {
+        m_hash ^= s_tables.cell_hash[cell][BlackPlayer][1 << entry];
+    }
+
+    m_white &= ~bit;
+    m_black &= ~bit;
+    if(value == WhiteEntry) {
+        m_white |= bit;
+        m_hash ^= s_tables.cell_hash[cell][WhitePlayer][1 << entry];
+    } else if(value == BlackEntry) {
+        m_black |= bit;
+        m_hash ^= s_tables.cell_hash[cell][BlackPlayer][1 << entry];
+    }
 }
 
-inline Board::Board() { 
-    m_board.fill(EmptyEntry); 
+template<int CellSize, int CellsPerRow, int WinSize>
+inline BasicBoard<CellSize, CellsPerRow, WinSize>::BasicBoard():
+    m_white(0), m_black(0), m_hash(0)
+{ 
 }
  
-inline Board::Board(const Board& other):
-    m_board(other.m_board)
+template<int CellSize, int CellsPerRow, int WinSize>
+inline BasicBoard<CellSize, CellsPerRow, WinSize>::BasicBoard(const BasicBoard& other):
+    m_white(other.m_white), m_black(other.m_black), m_hash(other.m_hash)
 { 
 }
  
-inline Board Board::clone() const
+template<int CellSize, int CellsPerRow, int WinSize>
+inline BasicBoard<CellSize, CellsPerRow, WinSize>::BasicBoard(Mask white, Mask black):
+    m_white(white), m_black(black), m_hash(compute_hash(white, black))
+{ 
+}
+ 
+template<int CellSize, int CellsPerRow, int WinSize>
+inline BasicBoard<CellSize, CellsPerRow, WinSize> BasicBoard<CellSize, CellsPerRow, WinSize>::clone() const
+{
+    return BasicBoard(*this);  
+}
+
+template<int CellSize, int CellsPerRow, int WinSize>
+inline typename BasicBoard<CellSize, CellsPerRow, WinSize>::Mask BasicBoard<CellSize, CellsPerRow, WinSize>::player_mask(PlayerColor color) const
 {
-    return Board(*this);  
+    return color == WhitePlayer ? m_white : m_black;
 }
  
-inline void Board::apply_move_no_check(const Move& move, PlayerColor color)
+template<int CellSize, int CellsPerRow, int WinSize>
+inline void BasicBoard<CellSize, CellsPerRow, WinSize>::apply_move_no_check(const Move& move, PlayerColor color)
+{
+    make_move(move, color);
+}
+
+template<int CellSize, int CellsPerRow, int WinSize>
+inline void BasicBoard<CellSize, CellsPerRow, WinSize>::make_move(const Move& move, PlayerColor color)
 {
     set_value(move.play_cell(), move.play_index(), player_color_to_board_entry(color));
     rotate_cell(move.rotate_cell(), move.rotation_direction()); 
 }
- 
-inline void Board::cell_to_absolute_pos(int cell, int entry, int& x, int& y) const
+
+template<int CellSize, int CellsPerRow, int WinSize>
+inline void BasicBoard<CellSize, CellsPerRow, WinSize>::unmake_move(const Move& move)
+{
+    rotate_cell(move.rotate_cell(), reverse_direction(move.rotation_direction()));
+    set_value(move.play_cell(), move.play_index(), EmptyEntry);
+}
+
+template<int CellSize, int CellsPerRow, int WinSize>
+inline void BasicBoard<CellSize, CellsPerRow, WinSize>::make_move(PackedMove move, PlayerColor color)
+{
+    set_value(move.play_cell(), move.play_index(), player_color_to_board_entry(color));
+    rotate_cell(move.rotate_cell(), move.rotation_direction()); 
+}
+
+template<int CellSize, int CellsPerRow, int WinSize>
+inline void BasicBoard<CellSize, CellsPerRow, WinSize>::unmake_move(PackedMove move)
+{
+    rotate_cell(move.rotate_cell(), reverse_direction(move.rotation_direction()));
+    set_value(move.play_cell(), move.play_index(), EmptyEntry);
+}
+
+template<int CellSize, int CellsPerRow, int WinSize>
+inline int BasicBoard<CellSize, CellsPerRow, WinSize>::generate_moves(PackedMove* moves) const
+{
+    int count = 0;
+    Mask empty = empty_mask();
+
+    while(empty) {
+        int index = lowest_entry(empty);
+        empty &= empty - 1;
+
+        int cell = s_tables.entry_cell[index];
+        int entry = s_tables.entry_offset[index];
+        for(int rot_cell = 0; rot_cell < CELLS_PER_ROW*CELLS_PER_ROW; ++rot_cell) {
+            moves[count++] = PackedMove(cell, entry, rot_cell, RotateLeft);
+            moves[count++] = PackedMove(cell, entry, rot_cell, RotateRight);
+        }
+    }
+    return count;
+}
+
+template<int CellSize, int CellsPerRow, int WinSize>
+inline unsigned BasicBoard<CellSize, CellsPerRow, WinSize>::distinct_twists(int cell, int entry,
+        PlayerColor color) const
+{
+    Mask bit = Mask(1) << entry_index(cell, entry);
+    Mask white = color == WhitePlayer ? m_white | bit : m_white;
+    Mask black = color == BlackPlayer ? m_black | bit : m_black;
+
+    unsigned twists = 0;
+    int unchanged_cell = -1;
+    bool unchanged_elsewhere = false;
+    for(int rot_cell = 0; rot_cell < CELL_COUNT; ++rot_cell) {
+        int shift = rot_cell*CELL_ENTRIES;
+        int symmetry = s_tables.twist_symmetry[(white >> shift) & CELL_MASK] &
+            s_tables.twist_symmetry[(black >> shift) & CELL_MASK];
+
+        if(symmetry & QUARTER_TWIST_SYMMETRIC) {
+            if(unchanged_cell < 0) {
+                twists |= 1u << (rot_cell*2 + RotateLeft);
+                unchanged_cell = rot_cell;
+            }
+            unchanged_elsewhere |= (rot_cell != cell);
+        } else if(symmetry & HALF_TWIST_SYMMETRIC) {
+            twists |= 1u << (rot_cell*2 + RotateLeft);
+        } else {
+            twists |= 3u << (rot_cell*2);
+        }
+    }
+
+    //Only twists of the played cell, and the twist that changes nothing, can
+    //give the position of a placement elsewhere in the cell.
+    int shift = cell*CELL_ENTRIES;
+    int own = (player_mask(color) >> shift) & CELL_MASK;
+    int other = (player_mask(opposing_color(color)) >> shift) & CELL_MASK;
+    int own_after = own | (1 << entry);
+    if(unchanged_cell >= 0 &&
+            lower_entry_reaches(own, other, entry, own_after, other, unchanged_elsewhere)) {
+        twists &= ~(1u << (unchanged_cell*2 + RotateLeft));
+    }
+    for(int dir = RotateLeft; dir <= RotateRight; ++dir) {
+        unsigned twist = 1u << (cell*2 + dir);
+        if(cell != unchanged_cell && (twists & twist) &&
+                lower_entry_reaches(own, other, entry, s_tables.rotation[dir][own_after],
+                    s_tables.rotation[dir][other], unchanged_elsewhere)) {
+            twists &= ~twist;
+        }
+    }
+    return twists;
+}
+
+//The lower placement's cell after its twist is (own_after, other_after), so
+//before the twist it is the same patterns twisted back, or unchanged.
+template<int CellSize, int CellsPerRow, int WinSize>
+inline bool BasicBoard<CellSize, CellsPerRow, WinSize>::lower_entry_reaches(int own, int other,
+        int entry, int own_after, int other_after, bool unchanged_elsewhere)
+{
+    auto placed_below = [&](int placed_own, int placed_other) {
+        int added = placed_own & ~own;
+        return placed_other == other && (placed_own & own) == own && added != 0 &&
+            (added & (added - 1)) == 0 && added < (1 << entry);
+    };
+
+    int symmetry = s_tables.twist_symmetry[own_after] & s_tables.twist_symmetry[other_after];
+    if(placed_below(own_after, other_after) &&
+            (unchanged_elsewhere || (symmetry & QUARTER_TWIST_SYMMETRIC))) {
+        return true;
+    }
+    for(int dir = RotateLeft; dir <= RotateRight; ++dir) {
+        if(placed_below(s_tables.rotation[dir][own_after], s_tables.rotation[dir][other_after])) {
+            return true;
+        }
+    }
+    return false;
+}
+
+template<int CellSize, int CellsPerRow, int WinSize>
+inline int BasicBoard<CellSize, CellsPerRow, WinSize>::generate_distinct_moves(PlayerColor color,
+        PackedMove* moves) const
+{
+    int count = 0;
+    Mask empty = empty_mask();
+
+    while(empty) {
+        int index = lowest_entry(empty);
+        empty &= empty - 1;
+
+        int cell = s_tables.entry_cell[index];
+        int entry = s_tables.entry_offset[index];
+        unsigned twists = distinct_twists(cell, entry, color);
+        for(int rot_cell = 0; rot_cell < CELL_COUNT; ++rot_cell) {
+            if(twists & (1u << (rot_cell*2 + RotateLeft))) {
+                moves[count++] = PackedMove(cell, entry, rot_cell, RotateLeft);
+            }
+            if(twists & (1u << (rot_cell*2 + RotateRight))) {
+                moves[count++] = PackedMove(cell, entry, rot_cell, RotateRight);
+            }
+        }
+    }
+    return count;
+}
+
+template<int CellSize, int CellsPerRow, int WinSize>
+inline int BasicBoard<CellSize, CellsPerRow, WinSize>::generate_winning_moves(PlayerColor color,
+        PackedMove* moves) const
+{
+    return winning_moves(player_mask(color), player_mask(opposing_color(color)), moves, MAX_MOVES);
+}
+
+template<int CellSize, int CellsPerRow, int WinSize>
+inline bool BasicBoard<CellSize, CellsPerRow, WinSize>::has_winning_move(PlayerColor color) const
+{
+    PackedMove move;
+    return winning_moves(player_mask(color), player_mask(opposing_color(color)), &move, 1) > 0;
+}
+
+template<int CellSize, int CellsPerRow, int WinSize>
+inline int BasicBoard<CellSize, CellsPerRow, WinSize>::generate_threats(PlayerColor color,
+        PackedMove* moves) const
+{
+    return generate_winning_moves(opposing_color(color), moves);
+}
+
+template<int CellSize, int CellsPerRow, int WinSize>
+inline typename BasicBoard<CellSize, CellsPerRow, WinSize>::Mask
+BasicBoard<CellSize, CellsPerRow, WinSize>::rotate_mask(Mask mask, int cell, RotationDirection dir)
 {
-    int cell_start_x = (cell % cells_per_row()) * cell_size();
-    int cell_start_y = (cell / cells_per_row()) * cell_size();
+    int shift = cell*CELL_ENTRIES;
+    Mask pattern = (mask >> shift) & CELL_MASK;
+    return (mask & ~(CELL_MASK << shift)) | (Mask(s_tables.rotation[dir][pattern]) << shift);
+}
+
+template<int CellSize, int CellsPerRow, int WinSize>
+inline void BasicBoard<CellSize, CellsPerRow, WinSize>::rotate_cell(int cell, RotationDirection dir)
+{
+    int shift = cell*CELL_ENTRIES;
+    Mask cell_mask = CELL_MASK << shift;
+
+    Mask white_pattern = (m_white >> shift) & CELL_MASK;
+    Mask black_pattern = (m_black >> shift) & CELL_MASK;
+    Mask white_bits = s_tables.rotation[dir][white_pattern];
+    Mask black_bits = s_tables.rotation[dir][black_pattern];
+
+    m_hash ^= s_tables.cell_hash[cell][WhitePlayer][white_pattern] ^
+        s_tables.cell_hash[cell][WhitePlayer][white_bits] ^
+        s_tables.cell_hash[cell][BlackPlayer][black_pattern] ^
+        s_tables.cell_hash[cell][BlackPlayer][black_bits];
+
+    m_white = (m_white & ~cell_mask) | (white_bits << shift);
+    m_black = (m_black & ~cell_mask) | (black_bits << shift);
+}
+
+template<int CellSize, int CellsPerRow, int WinSize>
+inline WinStatus BasicBoard<CellSize, CellsPerRow, WinSize>::win_status(bool white_win, bool black_win)
+{
+    if(white_win && !black_win) {
+        return WhiteWin;
+    } else if(black_win && !white_win) {
+        return BlackWin;
+    } else if(black_win && white_win) {
+        return Tie;
+    } else {
+        return NoWin;
+    }
+}
+
+template<int CellSize, int CellsPerRow, int WinSize>
+inline WinStatus BasicBoard<CellSize, CellsPerRow, WinSize>::check_masks(Mask white, Mask black)
+{
+    bool white_win = false;
+    bool black_win = false;
+
+    for(int i = 0; i < WIN_LINE_COUNT; ++i) {
+        Mask line = s_tables.win_lines[i];
+        white_win |= (white & line) == line;
+        black_win |= (black & line) == line;
+    }
+
+    return win_status(white_win, black_win);
+}
+
+template<int CellSize, int CellsPerRow, int WinSize>
+inline WinStatus BasicBoard<CellSize, CellsPerRow, WinSize>::check_for_wins() const
+{
+    return check_masks(m_white, m_black);
+}
 
-    int cell_offset_x = entry % cell_size();
-    int cell_offset_y = entry / cell_size();
+template<int CellSize, int CellsPerRow, int WinSize>
+inline void BasicBoard<CellSize, CellsPerRow, WinSize>::check_lines(const LineList& lines, bool& white_win,
+        bool& black_win) const
+{
+    for(int i = 0; i < lines.count; ++i) {
+        Mask line = s_tables.win_lines[lines.lines[i]];
+        white_win |= (m_white & line) == line;
+        black_win |= (m_black & line) == line;
+    }
+}
 
-    x = cell_start_x + cell_offset_x;
-    y = cell_start_y + cell_offset_y;
+template<int CellSize, int CellsPerRow, int WinSize>
+inline bool BasicBoard<CellSize, CellsPerRow, WinSize>::check_full() const
+{
+    return occupied_mask() == FULL_MASK;
+}
  
+template<int CellSize, int CellsPerRow, int WinSize>
+inline void BasicBoard<CellSize, CellsPerRow, WinSize>::cell_to_absolute_pos(int cell, int entry, int& x, int& y) const
+{
+    int index = entry_index(cell, entry);
+    x = s_tables.entry_x[index];
+    y = s_tables.entry_y[index];
+}
+
+template<int CellSize, int CellsPerRow, int WinSize>
+inline void BasicBoard<CellSize, CellsPerRow, WinSize>::absolute_pos_to_cell(int x, int y, int& cell, int& entry) const
+{
+    int index = absolute_index(x, y);
+    cell = s_tables.entry_cell[index];
+    entry = s_tables.entry_offset[index];
+}
+
+template<int CellSize, int CellsPerRow, int WinSize>
+inline int BasicBoard<CellSize, CellsPerRow, WinSize>::absolute_index(int x, int y)
+{
+    return s_tables.absolute_entry[x + y*BOARD_SIZE];
+}
+
+template<int CellSize, int CellsPerRow, int WinSize>
+inline int BasicBoard<CellSize, CellsPerRow, WinSize>::lowest_entry(Mask mask)
+{
+    if constexpr(sizeof(Mask) <= sizeof(unsigned long long)) {
+        return __builtin_ctzll(mask);
+    } else {
+        std::uint64_t low = static_cast<std::uint64_t>(mask);
+        if(low) {
+            return __builtin_ctzll(low);
+        }
+        return 64 + __builtin_ctzll(static_cast<std::uint64_t>(mask >> 64));
+    }
 }
 
+template<int CellSize, int CellsPerRow, int WinSize>
+inline int BasicBoard<CellSize, CellsPerRow, WinSize>::count_entries(Mask mask)
+{
+    if constexpr(sizeof(Mask) <= sizeof(unsigned long long)) {
+        return __builtin_popcountll(mask);
+    } else {
+        return __builtin_popcountll(static_cast<std::uint64_t>(mask)) +
+            __builtin_popcountll(static_cast<std::uint64_t>(mask >> 64));
+    }
+}
+
+extern template class BasicBoard<3, 2, 5>;
+extern template class BasicBoard<3, 3, 5>;
+
 #endif
-    
@@ -5,7 +5,8 @@
 
 #include "PlayerController.h"
 
-int ControllerFactory::register_constructor(std::string prompt,
+template<typename BoardType>
+int BasicControllerFactory<BoardType>::register_constructor(std::string prompt,
         ConstructorFnType constructor)
 {
     m_constructors.push_back(constructor);
@@ -14,8 +15,9 @@ int ControllerFactory::register_constructor(std::string prompt,
     return m_constructors.size()-1;
 }
  
-PlayerController* ControllerFactory::construct(int controller_id, std::string name,
-        PlayerColor color, const Board& initial_board) const
+template<typename BoardType>
+typename BasicControllerFactory<BoardType>::PlayerController* BasicControllerFactory<BoardType>::construct(int controller_id, std::string name,
+        PlayerColor color, const BoardType& initial_board) const
 {
     auto controller = m_constructors[controller_id](std::move(name), color, initial_board);
 
@@ -23,8 +25,10 @@ PlayerController* ControllerFactory::construct(int controller_id, std::string na
     return controller;
 }
  
-PlayerController* ControllerFactory::prompt_user_controller_selection(std::string name,
-        PlayerColor color, const Board& initial_board) const
+template<typename BoardType>
+typename BasicControllerFactory<BoardType>::PlayerController*
+BasicControllerFactory<BoardType>::prompt_user_controller_selection(std::string name,
+        PlayerColor color, const BoardType& initial_board) const
 {
 
     while(true) {
@@ -48,4 +52,6 @@ PlayerController* ControllerFactory::prompt_user_controller_selection(std::strin
     }
     return nullptr;
 }
- 
+
+template class BasicControllerFactory<Board>;
+template class BasicControllerFactory<LargeBoard>;
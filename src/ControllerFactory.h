@@ -3,36 +3,43 @@
 
 #include <vector>
 #include <functional>
+#include <string>
 
 #include "Enums.h"
+#include "Board.h"
 
-class PlayerController;
-class Board;
+template<typename BoardType> class BasicPlayerController;
 
-class ControllerFactory
+template<typename BoardType>
+class BasicControllerFactory
 {
 public:
+    typedef BasicPlayerController<BoardType> PlayerController;
 
-    typedef std::function<PlayerController* (std::string, PlayerColor, const Board&)> ConstructorFnType;
+    typedef std::function<PlayerController* (std::string, PlayerColor, const BoardType&)> ConstructorFnType;
 
-    ControllerFactory() {};
-    ~ControllerFactory() {};
+    BasicControllerFactory() {};
+    ~BasicControllerFactory() {};
 
     int constructor_count() const {return m_constructors.size();}
 
     int register_constructor(std::string prompt, ConstructorFnType constructor);
 
     PlayerController* construct(int controller_id, std::string name, PlayerColor color,
-            const Board& initial_board) const;
+            const BoardType& initial_board) const;
 
     PlayerController* prompt_user_controller_selection(std::string name, PlayerColor color,
-            const Board& initial_board) const;
+            const BoardType& initial_board) const;
 private:
 
     std::vector<ConstructorFnType> m_constructors;
     std::vector<std::string> m_prompts;
 };
 
+typedef BasicControllerFactory<Board> ControllerFactory;
+
+extern template class BasicControllerFactory<Board>;
+extern template class BasicControllerFactory<LargeBoard>;
 
 #endif
     
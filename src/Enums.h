@@ -26,11 +26,17 @@ enum PlayerColor {
 
 BoardEntry player_color_to_board_entry(PlayerColor color);
 
+//Return the win status of a win by the given color.
+WinStatus player_color_to_win_status(PlayerColor color);
+
 BoardEntry board_entry_from_char(char ch);
 
 //Return the color of the opponent, if the player's color is color.
 PlayerColor opposing_color(PlayerColor color);
 
+//Return the rotation that undoes a rotation in the given direction.
+RotationDirection reverse_direction(RotationDirection direction);
+
 inline BoardEntry player_color_to_board_entry(PlayerColor color)
 {
     switch(color) {
@@ -40,6 +46,15 @@ inline BoardEntry player_color_to_board_entry(PlayerColor color)
     } 
 }
 
+inline WinStatus player_color_to_win_status(PlayerColor color)
+{
+    if(color == WhitePlayer) {
+        return WhiteWin;
+    } else {
+        return BlackWin;
+    }
+}
+
 inline PlayerColor opposing_color(PlayerColor color)
 {
     if(color == WhitePlayer) {
@@ -49,4 +64,13 @@ inline PlayerColor opposing_color(PlayerColor color)
     } 
 }
 
+inline RotationDirection reverse_direction(RotationDirection direction)
+{
+    if(direction == RotateLeft) {
+        return RotateRight;
+    } else {
+        return RotateLeft;
+    }
+}
+
 #endif
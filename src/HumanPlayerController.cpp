@@ -3,12 +3,14 @@
 #include <iostream>
 #include <stdexcept>
 
-HumanPlayerController::HumanPlayerController(std::string name, PlayerColor color):
-    PlayerController(name, color)
+template<typename BoardType>
+BasicHumanPlayerController<BoardType>::BasicHumanPlayerController(std::string name, PlayerColor color):
+    BasicPlayerController<BoardType>(name, color)
 {
 }
  
-Move HumanPlayerController::make_move(const Board& board, const Pentago& game)
+template<typename BoardType>
+Move BasicHumanPlayerController<BoardType>::make_move(const BoardType& board, const BasicPentago<BoardType>& game)
 {
     //Keep asking for moves until a move is of the correct format.
     while(true) {
@@ -22,4 +24,6 @@ Move HumanPlayerController::make_move(const Board& board, const Pentago& game)
         }
     }
 }
- 
+
+template class BasicHumanPlayerController<Board>;
+template class BasicHumanPlayerController<LargeBoard>;
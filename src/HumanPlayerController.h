@@ -5,17 +5,23 @@
 
 //A PlayerController allowing a human player to control the moves through 
 //the terminal.
-class HumanPlayerController: public PlayerController
+template<typename BoardType>
+class BasicHumanPlayerController: public BasicPlayerController<BoardType>
 {
 public:
-    HumanPlayerController(std::string name, PlayerColor color);
-    ~HumanPlayerController();
+    BasicHumanPlayerController(std::string name, PlayerColor color);
+    ~BasicHumanPlayerController() {};
 
-    virtual Move make_move(const Board& board, const Pentago& game);
+    virtual Move make_move(const BoardType& board, const BasicPentago<BoardType>& game);
 
 protected:
 private:
 };
 
+typedef BasicHumanPlayerController<Board> HumanPlayerController;
+
+extern template class BasicHumanPlayerController<Board>;
+extern template class BasicHumanPlayerController<LargeBoard>;
+
 #endif
     
@@ -2,41 +2,213 @@
 
 #include <algorithm>
 #include <iostream>
+#include <array>
+#include <cstdlib>
 
-MctsComputerController::MctsComputerController(std::string name, PlayerColor color,
-        const Board& board): PlayerController(name, color)
+//Trials per move, and per opponent reply when predicting the reply to
+//ponder on.
+static const int TRIAL_COUNT = 1000;
+static const int PREDICTION_TRIAL_COUNT = 100;
+
+template<typename BoardType>
+BasicMctsComputerController<BoardType>::BasicMctsComputerController(std::string name, PlayerColor color,
+        const BoardType& board): BasicPlayerController<BoardType>(name, color),
+    m_random(std::rand()), m_stop_pondering(false), m_ponder_predicted(false)
 {
     m_move_loc_list.resize(board.total_entries(), Move::invalid_move());
-    m_random_move_set.resize(37, Move::invalid_move());
+    m_random_move_set.resize(BoardType::TOTAL_ENTRIES+1, Move::invalid_move());
+}
+
+template<typename BoardType>
+BasicMctsComputerController<BoardType>::~BasicMctsComputerController()
+{
+    stop_pondering();
 }
  
-Move MctsComputerController::make_move(const Board& board, const Pentago& game)
+template<typename BoardType>
+Move BasicMctsComputerController<BoardType>::make_move(const BoardType& board, const BasicPentago<BoardType>& game)
 {
-    build_static_move_list(board);
+    //Take a win on the spot without running any trials.
+    std::array<PackedMove, BoardType::MAX_MOVES> winning_moves;
+    if(board.generate_winning_moves(color(), winning_moves.data()) > 0) {
+        stop_pondering();
+        return winning_moves[0].to_move();
+    }
+
+    if(finish_pondering(board)) {
+        std::cout << "ponder hit" << std::endl;
+    } else {
+        build_static_move_list(board, color());
+        evaluate_moves(board);
+    }
 
     float max_val = -1.0;
     Move best_move = Move::invalid_move();
-
     for(int i = 0; i < m_potential_moves.size(); ++i) {
+        if(m_move_scores[i] > max_val) {
+            max_val = m_move_scores[i];
+            best_move = m_potential_moves[i];
+        }
+    }
+    
+    std::cout << max_val << " - " << best_move << std::endl;
+
+    if(this->pondering_enabled()) {
+        start_pondering(board, best_move);
+    }
+    return best_move;
+}
+
+template<typename BoardType>
+void BasicMctsComputerController<BoardType>::opponent_moved(const BoardType& board,
+        const Move& move)
+{
+    if(!m_ponder_thread.joinable()) {
+        return;
+    }
+
+    bool hit;
+    {
+        std::lock_guard<std::mutex> lock(m_ponder_mutex);
+        hit = m_ponder_predicted && board.white_mask() == m_ponder_board.white_mask() &&
+            board.black_mask() == m_ponder_board.black_mask();
+    }
+    if(!hit) {
+        stop_pondering();
+    }
+}
+
+//Run the trials of each potential move on board, stopping early if pondering
+//is called off.
+template<typename BoardType>
+void BasicMctsComputerController<BoardType>::evaluate_moves(const BoardType& board)
+{
+    m_move_scores.assign(m_potential_moves.size(), -1.0);
+
+    BoardType move_board = board.clone();
+
+    for(int i = 0; i < m_potential_moves.size() && !m_stop_pondering; ++i) {
+        Move move = m_potential_moves[i];
+        move_board.make_move(move, color());
+
+        m_move_scores[i] = monte_carlo_trials(move_board, opposing_color(color()),
+                TRIAL_COUNT);
+
+        move_board.unmake_move(move);
+    }
+}
+
+//The opponent's reply on board that leaves us the fewest wins, on fewer
+//trials than our own moves get. Invalid if the opponent has a win on the
+//spot, or pondering was called off.
+template<typename BoardType>
+Move BasicMctsComputerController<BoardType>::predict_reply(const BoardType& board)
+{
+    PlayerColor opponent = opposing_color(color());
+    if(board.has_winning_move(opponent)) {
+        return Move::invalid_move();
+    }
+
+    build_static_move_list(board, opponent);
+
+    float min_val = 2.0;
+    Move reply = Move::invalid_move();
+
+    BoardType reply_board = board.clone();
+    for(int i = 0; i < m_potential_moves.size() && !m_stop_pondering; ++i) {
         Move move = m_potential_moves[i];
-        Board move_board = board.clone();
-        move_board.apply_move_no_check(move, color());
+        reply_board.make_move(move, opponent);
 
-        float score = monte_carlo_trials(move_board, 1000);
+        float score = monte_carlo_trials(reply_board, color(), PREDICTION_TRIAL_COUNT);
 
-        if(score > max_val) {
-            max_val = score;
-            best_move = move;
+        reply_board.unmake_move(move);
+
+        if(score < min_val) {
+            min_val = score;
+            reply = move;
         }
+    }
+    return m_stop_pondering ? Move::invalid_move() : reply;
+}
 
-        //std::cout << score << " - " << move << std::endl;
-    } 
-    
-    std::cout << max_val << " - " << best_move << std::endl;
-    return best_move;
+//board is the position after our move.
+template<typename BoardType>
+void BasicMctsComputerController<BoardType>::start_pondering(const BoardType& board,
+        const Move& move)
+{
+    BoardType ponder_board = board.clone();
+    if(ponder_board.apply_move(move, color()) != NoWin ||
+            ponder_board.check_for_wins() != NoWin || ponder_board.check_full()) {
+        return;
+    }
+
+    m_stop_pondering = false;
+    m_ponder_predicted = false;
+    m_ponder_thread = std::thread(&BasicMctsComputerController::ponder, this, ponder_board);
 }
- 
-void MctsComputerController::build_static_move_list(const Board& board)
+
+template<typename BoardType>
+void BasicMctsComputerController<BoardType>::ponder(BoardType board)
+{
+    Move reply = predict_reply(board);
+    if(reply.is_invalid()) {
+        return;
+    }
+    if(board.apply_move(reply, opposing_color(color())) != NoWin ||
+            board.check_for_wins() != NoWin || board.check_full()) {
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(m_ponder_mutex);
+        m_ponder_board = board;
+        m_ponder_predicted = true;
+    }
+
+    build_static_move_list(board, color());
+    evaluate_moves(board);
+}
+
+//Wait for the ponder thread if it is working on board, and stop it
+//otherwise. Returns whether it was, in which case the potential moves and
+//their scores are those of board.
+template<typename BoardType>
+bool BasicMctsComputerController<BoardType>::finish_pondering(const BoardType& board)
+{
+    if(!m_ponder_thread.joinable()) {
+        return false;
+    }
+
+    bool hit;
+    {
+        std::lock_guard<std::mutex> lock(m_ponder_mutex);
+        hit = m_ponder_predicted && board.white_mask() == m_ponder_board.white_mask() &&
+            board.black_mask() == m_ponder_board.black_mask();
+    }
+    if(!hit) {
+        stop_pondering();
+        return false;
+    }
+
+    m_ponder_thread.join();
+    m_ponder_predicted = false;
+    return true;
+}
+
+template<typename BoardType>
+void BasicMctsComputerController<BoardType>::stop_pondering()
+{
+    if(m_ponder_thread.joinable()) {
+        m_stop_pondering = true;
+        m_ponder_thread.join();
+    }
+    m_stop_pondering = false;
+    m_ponder_predicted = false;
+}
+
+template<typename BoardType>
+void BasicMctsComputerController<BoardType>::build_static_move_list(const BoardType& board,
+        PlayerColor mover)
 
 {
     const int MOVES_PER_ENTRY = board.cell_count()*2;
@@ -51,46 +223,67 @@ void MctsComputerController::build_static_move_list(const Board& board)
         }
     }
 
-    std::random_shuffle(m_move_loc_list.begin(), m_move_loc_list.begin()+move_count);
+    std::shuffle(m_move_loc_list.begin(), m_move_loc_list.begin()+move_count, m_random);
     
 
     m_potential_moves.clear();
     m_potential_moves.reserve(move_count*board.cell_count()*2);
 
+    //Moves that give the same position as another move are left out.
     for(int i = 0; i < move_count; ++i) {
+        int cell = m_move_loc_list[i].play_cell();
+        int entry = m_move_loc_list[i].play_index();
+        unsigned twists = board.distinct_twists(cell, entry, mover);
+
         for(int rot_cell = 0; rot_cell < board.cell_count(); ++rot_cell) {
-            m_potential_moves.push_back(Move(m_move_loc_list[i].play_cell(),
-                    m_move_loc_list[i].play_index(), rot_cell, RotateLeft));
-            m_potential_moves.push_back(Move(m_move_loc_list[i].play_cell(),
-                    m_move_loc_list[i].play_index(), rot_cell, RotateRight));
+            if(twists & (1u << (rot_cell*2 + RotateLeft))) {
+                m_potential_moves.push_back(Move(cell, entry, rot_cell, RotateLeft));
+            }
+            if(twists & (1u << (rot_cell*2 + RotateRight))) {
+                m_potential_moves.push_back(Move(cell, entry, rot_cell, RotateRight));
+            }
         }        
     }
 }
 
-float MctsComputerController::monte_carlo_trials(const Board& board, int count)
+template<typename BoardType>
+float BasicMctsComputerController<BoardType>::monte_carlo_trials(const BoardType& board,
+        PlayerColor to_move, int count)
 {
     int wins = 0;
     for(int i = 0; i < count; ++i) {
         build_move_list(board);
-        if(monte_carlo_trial(board)) {
+        if(monte_carlo_trial(board, to_move)) {
             wins += 1;
         }
     } 
     return static_cast<float>(wins) / static_cast<float>(count);
 }
  
-bool MctsComputerController::monte_carlo_trial(const Board& board)
+//Play out board at random from to_move's turn. Returns whether we won.
+template<typename BoardType>
+bool BasicMctsComputerController<BoardType>::monte_carlo_trial(const BoardType& board,
+        PlayerColor to_move)
 {
-    PlayerColor player_color = color();
-    PlayerColor opponent_color = opposing_color(player_color);
-    std::swap(player_color, opponent_color);
+    PlayerColor player_color = to_move;
+    PlayerColor opponent_color = opposing_color(to_move);
 
     WinStatus win_status = board.check_for_wins();
 
-    Board board_copy = board.clone();
+    //The random move set is drawn from the entries empty at the start of the
+    //trial, and twists can move stones onto them, so playouts cannot be
+    //unmade and run on a copy instead.
+    BoardType board_copy = board.clone();
 
     int i = 0;
-    while(win_status == NoWin && i < 36) {
+    while(win_status == NoWin && i < BoardType::TOTAL_ENTRIES) {
+        //A random move would often miss a win on the spot, so either side
+        //takes one as soon as it is available.
+        if(board_copy.has_winning_move(player_color)) {
+            win_status = player_color_to_win_status(player_color);
+            break;
+        }
+
         Move move = m_random_move_set[i];
         if(move.is_invalid()) {
             break;
@@ -101,8 +294,6 @@ bool MctsComputerController::monte_carlo_trial(const Board& board)
         win_status = board_copy.check_for_wins();
     }
 
-    win_status = board_copy.check_for_wins();
-
     if((win_status == WhiteWin && color() == WhitePlayer) ||
             (win_status == BlackWin && color() == BlackPlayer)) {
         return true;
@@ -111,21 +302,24 @@ bool MctsComputerController::monte_carlo_trial(const Board& board)
     return false;
 }
  
-void MctsComputerController::build_move_list(const Board& board)
+template<typename BoardType>
+void BasicMctsComputerController<BoardType>::build_move_list(const BoardType& board)
 {
     int i = 0;
     for(int cell = 0; cell < board.cell_count(); ++cell) {
         for(int entry = 0; entry < board.entries_per_cell(); ++entry) {
             if(board.is_cell_empty(cell, entry)) {
-                int rot_cell = std::rand() % board.cell_count();
-                int dir = std::rand() % 2;
+                int rot_cell = m_random() % board.cell_count();
+                int dir = m_random() % 2;
                 m_random_move_set[i] = Move(cell, entry, rot_cell, 
                     dir == 0 ? RotateLeft : RotateRight);
                 i+=1;
             }
         } 
     }
-    std::random_shuffle(m_random_move_set.begin(), m_random_move_set.begin()+i);
+    std::shuffle(m_random_move_set.begin(), m_random_move_set.begin()+i, m_random);
     m_random_move_set[i] = Move::invalid_move();
 }
- 
+
+template class BasicMctsComputerController<Board>;
+template class BasicMctsComputerController<LargeBoard>;
@@ -4,31 +4,69 @@
 #include "PlayerController.h"
 
 #include <vector>
+#include <random>
+#include <thread>
+#include <mutex>
+#include <atomic>
 
 
-class MctsComputerController: public PlayerController
+template<typename BoardType>
+class BasicMctsComputerController: public BasicPlayerController<BoardType>
 {
 public:
-    MctsComputerController(std::string name, PlayerColor color, const Board& board);
-    ~MctsComputerController();
+    BasicMctsComputerController(std::string name, PlayerColor color, const BoardType& board);
+    ~BasicMctsComputerController();
 
-    virtual Move make_move(const Board& board, const Pentago& game);
+    virtual Move make_move(const BoardType& board, const BasicPentago<BoardType>& game);
+
+    //With pondering enabled, the controller guesses the opponent's reply after
+    //its move and runs the trials of the position after it while the opponent
+    //thinks. If the guess was right, the next make_move uses them.
+    virtual void opponent_moved(const BoardType& board, const Move& move);
 
 private:
+    using BasicPlayerController<BoardType>::color;
 
     std::vector<Move> m_potential_moves;
     std::vector<Move> m_move_loc_list;
 
+    //Win rate of each potential move, or -1 until its trials have run.
+    std::vector<float> m_move_scores;
+
     std::vector<Move> m_random_move_set;
 
-    void build_static_move_list(const Board& board);
+    //Trials draw from a generator of their own, so a ponder thread does not
+    //share std::rand with the rest of the program.
+    std::mt19937 m_random;
+
+    void build_static_move_list(const BoardType& board, PlayerColor mover);
+    void evaluate_moves(const BoardType& board);
+    Move predict_reply(const BoardType& board);
+
+    float monte_carlo_trials(const BoardType& board, PlayerColor to_move, int count);
+    bool monte_carlo_trial(const BoardType& board, PlayerColor to_move);
 
-    float monte_carlo_trials(const Board& board, int count);
-    bool monte_carlo_trial(const Board& board);
+    void build_move_list(const BoardType& board);
 
-    void build_move_list(const Board& board);
+    void start_pondering(const BoardType& board, const Move& move);
+    void ponder(BoardType board);
+    bool finish_pondering(const BoardType& board);
+    void stop_pondering();
+
+    std::thread m_ponder_thread;
+    std::atomic<bool> m_stop_pondering;
+
+    //The position after the predicted reply, once the ponder thread has
+    //predicted one.
+    std::mutex m_ponder_mutex;
+    bool m_ponder_predicted;
+    BoardType m_ponder_board;
 };
 
+typedef BasicMctsComputerController<Board> MctsComputerController;
+
+extern template class BasicMctsComputerController<Board>;
+extern template class BasicMctsComputerController<LargeBoard>;
 
 #endif
-    
+
@@ -4,22 +4,36 @@
 #include <iostream> 
 #include <algorithm>    
 #include <ctime>
+#include <thread>
+#include <functional>
 #include <cassert>
+#include <cmath>
 
 static const float POS_INF = 1e10;
 static const float NEG_INF = -1e10;
-static const int KILLER_COUNT = 4;
-
-bool scan_compare(BoardEntry entry, BoardEntry scan_entry, int& run_len);
-int horiz_scan(const Board& board, int x, int y, BoardEntry entry);
-int vert_scan(const Board& board, int x, int y, BoardEntry entry);
-int diag_scan(const Board& board, int x, int y, BoardEntry entry);
-int diag_scan_neg(const Board& board, int x, int y, BoardEntry entry);
-
-MinimaxComputerController::MinimaxComputerController(std::string name, PlayerColor color,
-        const Board& board, int max_depth, float max_turn_time):
-    PlayerController(name, color), m_max_depth(max_depth),
-    m_max_turn_time(max_turn_time)
+//History scores saturate at HISTORY_MAX. Countermoves sort ahead of any
+//history score.
+static const int HISTORY_MAX = 1 << 28;
+static const int COUNTERMOVE_SCORE = HISTORY_MAX + 1;
+
+//Quiet moves picked one at a time before the rest are sorted.
+static const int QUIET_PICK_COUNT = 3;
+
+//Half width of the first aspiration window, how much it grows on each
+//re-search, and the width past which it opens fully.
+static const float ASPIRATION_WINDOW = 2.0;
+static const float ASPIRATION_GROWTH = 4.0;
+static const float ASPIRATION_MAX = 100.0;
+
+template<typename BoardType>
+BasicMinimaxComputerController<BoardType>::BasicMinimaxComputerController(std::string name, PlayerColor color,
+        const BoardType& board, int max_depth, float max_turn_time, int table_size_mb,
+        int thread_count, ParallelMode parallel_mode, float game_time):
+    BasicPlayerController<BoardType>(name, color), m_table(table_size_mb),
+    m_max_depth(max_depth), m_thread_count(std::max(thread_count, 1)),
+    m_parallel_mode(parallel_mode), m_last_depth(0), m_last_score(0.0), m_last_node_evals(0),
+    m_last_search_time(0.0), m_time(max_turn_time, game_time), m_stop_search(false),
+    m_pondering(false), m_ponder_move(Move::invalid_move())
 {
 
     m_coeff_center_control = 2.50;
@@ -27,38 +41,239 @@ MinimaxComputerController::MinimaxComputerController(std::string name, PlayerCol
 
     m_move_loc_list.resize(board.total_entries(), Move::invalid_move());
     build_static_move_list(board);
-}
 
-MinimaxComputerController::~MinimaxComputerController() {
+    //Killers are indexed by remaining depth, which never exceeds the
+    //maximum depth.
+    m_thread_states.resize(m_thread_count);
+    for(int i = 0; i < m_thread_count; ++i) {
+        m_thread_states[i].thread_index = i;
+        m_thread_states[i].killer_moves.assign(KILLER_COUNT*(m_max_depth+1),
+                Move::invalid_move());
+    }
+}
 
+template<typename BoardType>
+BasicMinimaxComputerController<BoardType>::~BasicMinimaxComputerController() {
+    stop_pondering();
 }
 
-Move MinimaxComputerController::make_move(const Board& board, const Pentago& game) {
+template<typename BoardType>
+Move BasicMinimaxComputerController<BoardType>::make_move(const BoardType& board, const BasicPentago<BoardType>& game) {
     
-    m_time_cancel = false;
-    m_search_start_time = std::clock();
-    m_node_evals = 0;
+    //Each player fills about half of the entries left.
+    int moves_left = (BoardType::count_entries(board.empty_mask()) + 1) / 2;
     std::cout << "score = " << score_board(board) << std::endl;
 
-    build_static_move_list(board);
+    Move move = Move::invalid_move();
+    //Time the nodes were searched in, for the node rate.
+    double search_seconds = 0.0;
+    if(m_ponder_thread.joinable() && same_position(board, m_ponder_board)) {
+        //The opponent played the expected reply, so the ponder search is
+        //already searching this move. It runs against the clock from here.
+        m_time.start_move(moves_left);
+        m_pondering = false;
+        m_ponder_thread.join();
+        move = m_ponder_move;
+        search_seconds = std::chrono::duration<double>(
+                std::chrono::steady_clock::now() - m_ponder_start).count();
+        std::cout << "ponder hit" << std::endl;
+    } else {
+        stop_pondering();
+        m_time.start_move(moves_left);
+
+        //Take a win on the spot without searching.
+        std::array<PackedMove, BoardType::MAX_MOVES> winning_moves;
+        if(board.generate_winning_moves(color(), winning_moves.data()) > 0) {
+            m_time.end_move();
+            return winning_moves[0].to_move();
+        }
+
+        m_stop_search = false;
+        move = search(board);
+        search_seconds = m_time.elapsed_seconds();
+    }
+
+    m_last_search_time = m_time.elapsed_seconds();
+    m_time.end_move();
+
+    std::cout << "max = " << m_last_score << std::endl;
+    std::cout << "depth = " << m_last_depth << std::endl;
+
+    BoardType board_copy = board.clone();
+    board_copy.apply_move_no_check(move, color());
+
+    std::cout << "end score = " << score_board(board_copy) << std::endl;
+    std::cout << "node evals = " << m_last_node_evals << " on " << m_thread_count
+        << " threads, " << m_last_node_evals / search_seconds / m_thread_count / 1e3
+        << " k nodes/s per thread" << std::endl;
+    std::cout << "Move time: " << m_last_search_time << " seconds" << std::endl;
+
+    if(this->pondering_enabled()) {
+        start_pondering(board, move);
+    }
+    return move; 
+}
+
+template<typename BoardType>
+std::vector<Move> BasicMinimaxComputerController<BoardType>::killers(int depth_bound) const
+{
+    const std::vector<Move>& killer_moves = m_thread_states[0].killer_moves;
+    return std::vector<Move>(killer_moves.begin() + depth_bound*KILLER_COUNT,
+            killer_moves.begin() + (depth_bound+1)*KILLER_COUNT);
+}
+
+template<typename BoardType>
+void BasicMinimaxComputerController<BoardType>::opponent_moved(const BoardType& board,
+        const Move& move)
+{
+    //Free the threads as soon as the prediction turns out wrong.
+    if(m_ponder_thread.joinable() && !same_position(board, m_ponder_board)) {
+        stop_pondering();
+    }
+}
+
+//Ponder on the position after move and the reply the search expects, the
+//best move stored for the opponent in the transposition table. Nothing to do
+//if there is none, or the game would be over or won on the spot, which
+//make_move handles without a search.
+template<typename BoardType>
+void BasicMinimaxComputerController<BoardType>::start_pondering(const BoardType& board,
+        const Move& move)
+{
+    BoardType ponder_board = board.clone();
+    if(ponder_board.apply_move(move, color()) != NoWin ||
+            ponder_board.check_for_wins() != NoWin || ponder_board.check_full()) {
+        return;
+    }
+
+    TranspositionTable::Entry entry;
+    if(!m_table.probe(ponder_board.hash(), entry) || entry.best_move.is_invalid()) {
+        return;
+    }
+    Move reply = entry.best_move.to_move();
+    if(!ponder_board.is_cell_empty(reply.play_cell(), reply.play_index()) ||
+            ponder_board.apply_move(reply, opposing_color(color())) != NoWin ||
+            ponder_board.check_for_wins() != NoWin || ponder_board.check_full() ||
+            ponder_board.has_winning_move(color())) {
+        return;
+    }
+
+    m_ponder_board = ponder_board;
+    m_stop_search = false;
+    m_pondering = true;
+    m_ponder_start = std::chrono::steady_clock::now();
+    m_ponder_thread = std::thread([this]() {
+        m_ponder_move = search(m_ponder_board);
+    });
+}
+
+//Cancel the ponder search, if any, and throw its result away. What it stored
+//in the transposition table stays.
+template<typename BoardType>
+void BasicMinimaxComputerController<BoardType>::stop_pondering()
+{
+    if(m_ponder_thread.joinable()) {
+        m_stop_search = true;
+        m_ponder_thread.join();
+    }
+    m_pondering = false;
+}
+
+template<typename BoardType>
+bool BasicMinimaxComputerController<BoardType>::same_position(const BoardType& board,
+        const BoardType& other)
+{
+    return board.white_mask() == other.white_mask() && board.black_mask() == other.black_mask();
+}
+
+//Iterative deepening search for our move on board. While pondering, it runs
+//until stopped or out of depth; otherwise within the time budgets.
+template<typename BoardType>
+Move BasicMinimaxComputerController<BoardType>::search(const BoardType& board) {
+    m_table.new_search();
+    seed_principal_variation(board);
+
+    //Ordering tables and killers carry over from the last search, which saw
+    //most of this tree two plies up.
+    for(SearchState& thread_state : m_thread_states) {
+        thread_state.node_evals = 0;
+        thread_state.cancelled = false;
+        age_history(thread_state);
+    }
+
+    //Lazy SMP: helper threads run their own iterative deepening over the
+    //shared transposition table and only serve to fill it. The main thread's
+    //search alone picks the move.
+    //Young brothers wait: the main thread's search splits its nodes over the
+    //pool, whose threads search with their own state.
+    std::vector<std::thread> helpers;
+    if(m_thread_count > 1 && m_parallel_mode == YoungBrothersWait) {
+        m_pool.reset(new WorkStealingPool(m_thread_count));
+    } else {
+        for(int i = 1; i < m_thread_count; ++i) {
+            helpers.push_back(std::thread(&BasicMinimaxComputerController::helper_search, this,
+                        std::ref(m_thread_states[i]), board, i));
+        }
+    }
+    SearchState& state = m_thread_states[0];
 
     float max = 0.0;
     float old_max = 0.0;
 
-    int depth = 0;
+    //Completed score for each depth.
+    std::vector<float> depth_scores;
 
-    clock_t elapsed_time = std::clock() - m_search_start_time;
+    int depth = 0;
 
     Move move = Move::invalid_move();
 
+    //The search makes and unmakes moves on this single board.
+    BoardType search_board = board.clone();
+
     //Apply iterative deepening. This not only allows the highest depth for the
     //time constrait to be chosen, but guarentees that the quickest win will be
-    //selected.
-    while(elapsed_time <= m_max_turn_time*CLOCKS_PER_SEC && depth < m_max_depth) {
-        m_killer_moves.resize(KILLER_COUNT*(depth+1), Move::invalid_move());
-        Move new_move = minimax_2(board, depth, max);
-        if(!m_time_cancel) {
+    //selected. A new depth only starts within the soft time budget.
+    while(depth < m_max_depth && (m_pondering || !m_time.soft_limit_reached())) {
+        //Age history between depths. Depth 0 goes on from the ageing at the
+        //start of the search. Pool threads search parts of the main thread's
+        //tree, so they age along with it.
+        if(depth > 0) {
+            for(int i = 0; i < (m_pool ? m_thread_count : 1); ++i) {
+                age_history(m_thread_states[i]);
+            }
+        }
+        //Aspiration windows: search around the score of two depths back, and
+        //widen the side the score falls outside of until it lands inside.
+        //Scores swing between depths ending on our move and on the
+        //opponent's, so the last depth is a poor guess.
+        float alpha = NEG_INF*10;
+        float beta = POS_INF*10;
+        float window = ASPIRATION_WINDOW;
+        if(depth >= 2 && std::abs(depth_scores[depth-2]) < 1000.0) {
+            alpha = depth_scores[depth-2] - window;
+            beta = depth_scores[depth-2] + window;
+        }
+
+        Move new_move = minimax_2(state, search_board, depth, alpha, beta, max);
+        while(!state.cancelled && (max < alpha || max > beta)) {
+            window *= ASPIRATION_GROWTH;
+            if(max < alpha) {
+                alpha = (max < -1000.0 || window > ASPIRATION_MAX) ? NEG_INF*10 : max - window;
+            } else {
+                beta = (max > 1000.0 || window > ASPIRATION_MAX) ? POS_INF*10 : max + window;
+            }
+            new_move = minimax_2(state, search_board, depth, alpha, beta, max);
+        }
+
+        if(!state.cancelled) {
+            //Give the search more time while it keeps changing its mind.
+            //Depths 0 and 1 only see the next move or two, so their changes
+            //say little.
+            if(!m_pondering) {
+                m_time.iteration_done(depth >= 2 && new_move != move);
+            }
             move = new_move;
+            depth_scores.push_back(max);
             depth += 1;
         } else {
             max = old_max;
@@ -66,75 +281,192 @@ Move MinimaxComputerController::make_move(const Board& board, const Pentago& gam
         }
         
         //Check if we have a winning move. We should't go deeper if we do.
-        Board board_copy = board.clone();
+        BoardType board_copy = board.clone();
         WinStatus early_win = board_copy.apply_move(new_move, color());
         WinStatus late_win = board_copy.check_for_wins();
         if(early_win == player_win_kind() || late_win == player_win_kind()) {
             break;
         }
 
-        elapsed_time = std::clock() - m_search_start_time;
         std::swap(old_max, max);
     }
 
-    std::cout << "max = " << max << std::endl;
-    std::cout << "depth = " << depth << std::endl;
+    m_stop_search = true;
+    for(std::thread& helper : helpers) {
+        helper.join();
+    }
+    m_pool.reset();
+
+    m_last_depth = depth;
+    m_last_score = max;
+    m_last_node_evals = 0;
+    for(const SearchState& thread_state : m_thread_states) {
+        m_last_node_evals += thread_state.node_evals;
+    }
 
-    Board board_copy = board.clone();
-    board_copy.apply_move_no_check(move, color());
+    save_principal_variation(board, depth);
 
-    std::cout << "end score = " << score_board(board_copy) << std::endl;
-    std::cout << "node evals = " << m_node_evals << std::endl;
+    return move;
+}
 
-    clock_t end_time = std::clock();
+//Follow the best moves stored in the transposition table from board, for at
+//most depth moves or until the game would be over.
+template<typename BoardType>
+void BasicMinimaxComputerController<BoardType>::save_principal_variation(const BoardType& board,
+        int depth)
+{
+    m_pv_board = board.clone();
+    m_principal_variation.clear();
+
+    BoardType pv_board = board.clone();
+    PlayerColor mover = color();
+    TranspositionTable::Entry entry;
+    while(int(m_principal_variation.size()) < depth && m_table.probe(pv_board.hash(), entry) &&
+            !entry.best_move.is_invalid()) {
+        Move move = entry.best_move.to_move();
+        if(!pv_board.is_cell_empty(move.play_cell(), move.play_index())) {
+            break;
+        }
+        m_principal_variation.push_back(move);
+        if(pv_board.apply_move(move, mover) != NoWin || pv_board.check_for_wins() != NoWin ||
+                pv_board.check_full()) {
+            break;
+        }
+        mover = opposing_color(mover);
+    }
+}
 
-    double elapsed_s = static_cast<double>(end_time - m_search_start_time) / CLOCKS_PER_SEC;
+//If board is the position two plies down the last principal variation, store
+//the rest of it as best moves of positions the table lost since, so the first
+//depths search it first. The stored bounds always hold and never cut off:
+//at least NEG_INF at our moves, at most POS_INF at the opponent's.
+template<typename BoardType>
+void BasicMinimaxComputerController<BoardType>::seed_principal_variation(const BoardType& board)
+{
+    if(m_principal_variation.size() < 3) {
+        return;
+    }
 
-    std::cout << "Move time: " << elapsed_s << " seconds" << std::endl;
+    BoardType pv_board = m_pv_board.clone();
+    pv_board.apply_move_no_check(m_principal_variation[0], color());
+    pv_board.apply_move_no_check(m_principal_variation[1], opposing_color(color()));
+    if(!same_position(pv_board, board)) {
+        return;
+    }
 
-    return move; 
+    PlayerColor mover = color();
+    TranspositionTable::Entry entry;
+    for(std::size_t i = 2; i < m_principal_variation.size(); ++i) {
+        const Move& move = m_principal_variation[i];
+        if(!m_table.probe(pv_board.hash(), entry) || entry.best_move.is_invalid()) {
+            bool maximizing = mover == color();
+            m_table.store(pv_board.hash(), 0, maximizing ? TranspositionTable::LowerBound :
+                    TranspositionTable::UpperBound, maximizing ? NEG_INF*10 : POS_INF*10,
+                    PackedMove(move));
+        }
+        pv_board.apply_move_no_check(move, mover);
+        mover = opposing_color(mover);
+    }
+}
+
+//Iterative deepening for a helper thread, until the main thread is done.
+//Odd numbered helpers start a ply deeper than the main thread, so searches
+//of the next depth are under way while the main thread finishes the current
+//one.
+template<typename BoardType>
+void BasicMinimaxComputerController<BoardType>::helper_search(SearchState& state, BoardType board,
+        int thread_index)
+{
+    for(int depth = thread_index % 2; depth < m_max_depth && !m_stop_search; ++depth) {
+        if(depth > thread_index % 2) {
+            age_history(state);
+        }
+        float value = 0.0;
+        minimax_2(state, board, depth, NEG_INF*10, POS_INF*10, value);
+    }
 }
 
+//Check whether the search has to stop, because the turn time is up, the main
+//thread finished or a split point the thread works under was cut off, and
+//mark the thread's search as cancelled if so.
+template<typename BoardType>
+bool BasicMinimaxComputerController<BoardType>::search_stopped(SearchState& state)
+{
+    if(m_stop_search) {
+        state.cancelled = true;
+    } else if(!m_pondering && m_time.check_deadline(state.time_check_countdown)) {
+        //Out of time: stop every thread, not just the one that noticed.
+        m_stop_search = true;
+        state.cancelled = true;
+    }
+    for(const SplitPoint* split = state.split; split != nullptr && !state.cancelled;
+            split = split->parent) {
+        if(split->cutoff) {
+            state.cancelled = true;
+        }
+    }
+    return state.cancelled;
+}
  
-//Create a semi-random list of all valid moves given board. Only the play positions
-//are randomized, all 8 rotations for each move are together to allow for skipping
-//8 moves ahead any time a non-empty entry is found by minimax.
-void MinimaxComputerController::build_static_move_list(const Board& board)
+//Number of winning lines through the absolute position (x, y).
+static int lines_through(int board_size, int win_size, int x, int y)
+{
+    const int directions[4][2] = {{1, 0}, {0, 1}, {1, 1}, {1, -1}};
+
+    int count = 0;
+    for(const auto& dir : directions) {
+        for(int offset = 0; offset < win_size; ++offset) {
+            int start_x = x - offset*dir[0];
+            int start_y = y - offset*dir[1];
+            int end_x = start_x + (win_size-1)*dir[0];
+            int end_y = start_y + (win_size-1)*dir[1];
+            if(std::min(start_x, end_x) >= 0 && std::max(start_x, end_x) < board_size &&
+                    std::min(start_y, end_y) >= 0 && std::max(start_y, end_y) < board_size) {
+                count += 1;
+            }
+        }
+    }
+    return count;
+}
+
+//Order the play positions for the quiets stage, which scores their moves by
+//history. The order stands among moves without any history: play positions
+//on the most winning lines come first.
+template<typename BoardType>
+void BasicMinimaxComputerController<BoardType>::build_static_move_list(const BoardType& board)
 {
-    const int MOVES_PER_ENTRY = board.cell_count()*2;
 
     int move_count = 0;
-    //Shuffle the locations
     for(int cell = 0; cell < board.cell_count(); ++cell) {
         for(int entry = 0; entry < board.entries_per_cell(); ++entry) {
             m_move_loc_list[move_count] = Move(cell, entry, 1,  RotateRight);
             move_count += 1;
         }
     }
-    std::random_shuffle(m_move_loc_list.begin(), m_move_loc_list.begin()+move_count);
-
-    m_potential_moves.clear();
-    m_potential_moves.reserve(move_count*board.cell_count()*2+KILLER_COUNT);
-
-    //Killer move slots
-    for(int i = 0; i < KILLER_COUNT; ++i) {
-        m_potential_moves.push_back(Move::invalid_move());
-    }
 
-    //Build the actual moves from the locations
-    for(int i = 0; i < move_count; ++i) {
-        for(int rot_cell = 0; rot_cell < board.cell_count(); ++rot_cell) {
-            m_potential_moves.push_back(Move(m_move_loc_list[i].play_cell(),
-                    m_move_loc_list[i].play_index(), rot_cell, RotateLeft));
-            m_potential_moves.push_back(Move(m_move_loc_list[i].play_cell(),
-                    m_move_loc_list[i].play_index(), rot_cell, RotateRight));
-        }        
-    }
+    std::stable_sort(m_move_loc_list.begin(), m_move_loc_list.begin()+move_count,
+        [&board](const Move& a, const Move& b) {
+            int a_x, a_y, b_x, b_y;
+            board.cell_to_absolute_pos(a.play_cell(), a.play_index(), a_x, a_y);
+            board.cell_to_absolute_pos(b.play_cell(), b.play_index(), b_x, b_y);
+            return lines_through(board.board_size(), BoardType::WIN_SIZE, a_x, a_y) >
+                lines_through(board.board_size(), BoardType::WIN_SIZE, b_x, b_y);
+        });
 }
  
 //Return a score for the given board. A positive score represents a "good" situation
 //and a negative one represents a good situation for the opponent.
-float MinimaxComputerController::score_board(const Board& board)
+template<typename BoardType>
+float BasicMinimaxComputerController<BoardType>::score_board(const BoardType& board)
+{
+    return score_board(board, BasicRunTracker<BoardType>(board));
+}
+
+//Same as score_board(board), with the runs taken from runs, which must be up
+//to date with board.
+template<typename BoardType>
+float BasicMinimaxComputerController<BoardType>::score_board(const BoardType& board,
+        const BasicRunTracker<BoardType>& runs)
 {
     float player_score = 0.0;
     float opponent_score = 0.0;
@@ -147,7 +479,7 @@ float MinimaxComputerController::score_board(const Board& board)
     player_score += player_score_partial;
     opponent_score += opponent_score_partial;
 
-    run_scores(board, player_score_partial, opponent_score_partial);
+    run_scores(runs, player_score_partial, opponent_score_partial);
 
     player_score += player_score_partial;
     opponent_score += opponent_score_partial;
@@ -155,179 +487,29 @@ float MinimaxComputerController::score_board(const Board& board)
     return player_score - opponent_score;
 }
 
-//Scan for the top 3 runs of each player. This contains most of minimax's runtime.
-void MinimaxComputerController::find_runs(const Board& board,
+//The top 3 runs of each player, as the original scan of the board picked
+//them, from the line patterns kept in runs.
+template<typename BoardType>
+void BasicMinimaxComputerController<BoardType>::find_runs(const BasicRunTracker<BoardType>& runs,
         std::array<int, BEST_RUN_COUNT>& player_runs,
         std::array<int, BEST_RUN_COUNT>& opponent_runs) {
 
-    for(int y = 0; y < board.board_size(); ++y) {
-        for(int x = 0; x < board.board_size()-1; ++x) {
-            BoardEntry entry = board.get_value_absolute(x, y);
-
-            if(entry != EmptyEntry) {
-                int run_len = horiz_scan(board, x, y, entry);
-                add_run(player_runs, opponent_runs, run_len, entry);    
-            }
-        }        
-    }
-
-    for(int y = 0; y < board.board_size()-1; ++y) {
-        for(int x = 0; x < board.board_size(); ++x) {
-            BoardEntry entry = board.get_value_absolute(x, y);
-
-            if(entry != EmptyEntry) {
-                int run_len = vert_scan(board, x, y, entry);
-                add_run(player_runs, opponent_runs, run_len, entry);    
-            }
-        }        
-    }
-
-    for(int y = 0; y < board.board_size()-1; ++y) {
-        for(int x = 0; x < board.board_size()-1; ++x) {
-            BoardEntry entry = board.get_value_absolute(x, y);
-
-            if(entry != EmptyEntry) {
-                int run_len = diag_scan(board, x, y, entry);
-                add_run(player_runs, opponent_runs, run_len, entry);    
-            }
-        }        
-    }
-
-    for(int y = 1; y < board.board_size(); ++y) {
-        for(int x = 0; x < board.board_size()-1; ++x) {
-            BoardEntry entry = board.get_value_absolute(x, y);
-
-            if(entry != EmptyEntry) {
-                int run_len = diag_scan_neg(board, x, y, entry);
-                add_run(player_runs, opponent_runs, run_len, entry);    
-            }
-        }        
-    }
-}
-
-//Maintain the list of top 3 runs
-void insert_shift_down(int val, std::array<int, 3>& array) {
-    if(val > array[0]) {
-        array[2] = array[1];
-        array[1] = array[0];
-        array[0] = val;
-    } else if(val > array[1]) {
-        array[2] = array[1];
-        array[1] = val;
-    } else {
-        array[2] = val;
-    }
-}
-
-void MinimaxComputerController::add_run(
-        std::array<int, BEST_RUN_COUNT>& player_runs,
-        std::array<int, BEST_RUN_COUNT>& opponent_runs,
-        int run_len, BoardEntry entry_kind)
-{
-    if(run_len > player_runs[BEST_RUN_COUNT-1]) {
-        BoardEntry player_entry_kind = player_color_to_board_entry(color());
-        
-        bool is_player = (player_entry_kind == entry_kind); 
-        if(is_player) {
-            insert_shift_down(run_len, player_runs);
-        } else {
-            insert_shift_down(run_len, opponent_runs);
-        }
-    }
-}
-
-//Scanning helper functions. Easily inlined (mostly), these are a trade off between
-//readable/changable and fast code.
-
-int horiz_scan(const Board& board, int x, int y, BoardEntry entry) {
-    int run_len = 0;
-
-    for(int x2 = x+1; x2 < board.board_size(); ++x2) {
-        BoardEntry scan_entry = board.get_value_absolute(x2, y);
-
-        if(!scan_compare(entry, scan_entry, run_len)) {
-            break;
-        }
-
-        if(x2-x >= 4) {
-            break;
-        }
-    }
-
-    return run_len;
-}
-
-int vert_scan(const Board& board, int x, int y, BoardEntry entry) {
-    int run_len = 0;
-
-    for(int y2 = y+1; y2 < board.board_size(); ++y2) {
-        BoardEntry scan_entry = board.get_value_absolute(x, y2);
-
-        if(!scan_compare(entry, scan_entry, run_len)) {
-            break;
-        }
-        if(y2-y >= 4) {
-            break;
-        }
-    }
-
-    return run_len;
-}
-
-int diag_scan(const Board& board, int x, int y, BoardEntry entry) {
-    int run_len = 0;
-
-    int max_run = board.board_size() - std::max(x, y);
-    max_run = std::min(max_run, 5);
-    for(int off = 1; off < max_run; ++off) {
-        BoardEntry scan_entry = board.get_value_absolute(x+off, y+off);
-
-        if(!scan_compare(entry, scan_entry, run_len)) {
-            break;
-        }
-    }
-    return run_len;
-}
-
-int diag_scan_neg(const Board& board, int x, int y, BoardEntry entry) {
-    int run_len = 0;
-
-    int max_run = std::max(board.board_size() - x, y);
-    max_run = std::min(max_run, 5);
-    for(int off = 1; off < max_run; ++off) {
-        BoardEntry scan_entry = board.get_value_absolute(x+off, y-off);
-
-        if(!scan_compare(entry, scan_entry, run_len)) {
-            break;
-        }
-    }
-    return run_len;
-}
-
-
-bool scan_compare(BoardEntry entry, BoardEntry scan_entry, int& run_len) {
-    if(scan_entry == EmptyEntry) {
-        return true; 
-    } else if(entry == scan_entry) {
-        ++run_len;
-        return true;
-    } else {
-        return false;
-    }     
+    runs.scored_runs(color(), player_runs, opponent_runs);
 }
 
 //In general, center tiles are better than edge tiles (confirmed by a monte-carlo
 //tree search approach to the problem), so we give them a small positive score.
 //Really only affects the early game much.
-void MinimaxComputerController::center_control_scores(const Board& board,
+template<typename BoardType>
+void BasicMinimaxComputerController<BoardType>::center_control_scores(const BoardType& board,
         float& player_score, float& opponent_score)
 {
     BoardEntry player_entry_kind = player_color_to_board_entry(color());
     player_score = 0.0;
     opponent_score = 0.0;
 
-    for(int i = 0; i < 4; ++i) {
-        BoardEntry center_entry = board.get_value(i, 4);
+    for(int i = 0; i < board.cell_count(); ++i) {
+        BoardEntry center_entry = board.get_value(i, BoardType::CELL_ENTRIES/2);
         if(center_entry == player_entry_kind) {
             player_score += 1;
         } else if(center_entry != EmptyEntry) {
@@ -342,11 +524,12 @@ void MinimaxComputerController::center_control_scores(const Board& board,
 //Score runs. The top three are considered, with decreasing significants as you go down.
 //Scores for length are the length - 1 squared. This makes the ai more aggressively block
 //near wins.
-float MinimaxComputerController::run_score(const std::array<int, BEST_RUN_COUNT>& runs)
+template<typename BoardType>
+float BasicMinimaxComputerController<BoardType>::run_score(const std::array<int, BEST_RUN_COUNT>& runs)
 {
 
     float score = 0.0;
-    if(runs[0] >= Board::WIN_SIZE-1) {
+    if(runs[0] >= BoardType::WIN_SIZE-1) {
         return POS_INF;
     }
 
@@ -359,8 +542,9 @@ float MinimaxComputerController::run_score(const std::array<int, BEST_RUN_COUNT>
 }
  
 
-void MinimaxComputerController::run_scores(const Board& board,
-       float& player_score, float& opponent_score)
+template<typename BoardType>
+void BasicMinimaxComputerController<BoardType>::run_scores(
+        const BasicRunTracker<BoardType>& runs, float& player_score, float& opponent_score)
 {
     std::array<int, BEST_RUN_COUNT> player_runs;
     std::array<int, BEST_RUN_COUNT> opponent_runs;
@@ -368,58 +552,131 @@ void MinimaxComputerController::run_scores(const Board& board,
     player_runs.fill(0);
     opponent_runs.fill(0);
 
-    find_runs(board, player_runs, opponent_runs);
+    find_runs(runs, player_runs, opponent_runs);
 
     player_score = run_score(player_runs);
     opponent_score = run_score(opponent_runs);
 }
 
+template<typename BoardType>
+void BasicMinimaxComputerController<BoardType>::play_move(SearchState& state, BoardType& board,
+        const Move& move, PlayerColor mover)
+{
+    state.saved_runs.push_back(state.runs);
+    board.make_move(move, mover);
+    state.runs.update(board);
+}
+
+template<typename BoardType>
+void BasicMinimaxComputerController<BoardType>::take_back_move(SearchState& state,
+        BoardType& board, const Move& move)
+{
+    board.unmake_move(move);
+    state.runs = state.saved_runs.back();
+    state.saved_runs.pop_back();
+}
+
 //Minimax entry. Returns a chosen move.
-Move MinimaxComputerController::minimax_2(const Board& board, int depth_bound, float& value)
+template<typename BoardType>
+Move BasicMinimaxComputerController<BoardType>::minimax_2(SearchState& state, BoardType& board,
+        int depth_bound, float alpha, float beta, float& value)
 {
-    return minimax_max_value(board, depth_bound, NEG_INF*10, POS_INF*10, value); 
+    state.cancelled = false;
+    state.runs.reset(board);
+    return minimax_max_value(state, board, Move::invalid_move(), depth_bound, alpha, beta, value); 
+}
+
+//Value of the position on board, reached by move from a node with
+//depth_bound left and window (alpha, beta).
+//
+//Principal variation search: only the first move of a node gets the full
+//window. The others are searched with a null window at alpha (beta at min
+//nodes), which is enough to show they are no better, and searched again with
+//the full window only when they turn out to be.
+template<typename BoardType>
+float BasicMinimaxComputerController<BoardType>::move_value(SearchState& state, BoardType& board,
+        const Move& move, int depth_bound, float alpha, float beta, bool maximizing,
+        bool first_move)
+{
+    float value = 0.0;
+
+    if(depth_bound == 0) {
+        state.node_evals += 1;
+        return score_board(board, state.runs);
+    }
+
+    if(maximizing) {
+        if(!first_move) {
+            minimax_min_value(state, board, move, depth_bound-1, alpha, alpha, value);
+            if(value <= alpha || value > beta) {
+                return value;
+            }
+        }
+        minimax_min_value(state, board, move, depth_bound-1, alpha, beta, value);
+    } else {
+        if(!first_move) {
+            minimax_max_value(state, board, move, depth_bound-1, beta, beta, value);
+            if(value >= beta || value < alpha) {
+                return value;
+            }
+        }
+        minimax_max_value(state, board, move, depth_bound-1, alpha, beta, value);
+    }
+    return value;
 }
  
 //Minimax function for max levels of the tree. Adapted from the text book description.
-Move MinimaxComputerController::minimax_max_value(const Board& board, int depth_bound,
-        float alpha, float beta, float& value)
+template<typename BoardType>
+Move BasicMinimaxComputerController<BoardType>::minimax_max_value(SearchState& state, BoardType& board,
+        const Move& last_move, int depth_bound, float alpha, float beta, float& value)
 {
-    if(std::clock() - m_search_start_time >= CLOCKS_PER_SEC*m_max_turn_time) {
-        m_time_cancel = true;
+    if(search_stopped(state)) {
         return Move::invalid_move();
     }
 
-    m_node_evals += 1;
-    float board_score = score_board(board);
+    state.node_evals += 1;
+
+    Move hash_move = Move::invalid_move();
+    if(probe_table(board, depth_bound, alpha, beta, value, hash_move)) {
+        return hash_move;
+    }
+
+    float board_score = score_board(board, state.runs);
     if(board_score > 1000.0 || board_score < -1000.0) {
         value = board_score;
         return Move::invalid_move();
     }    
 
+    //A side that can win with its next move has won, so the node needs no
+    //expansion.
+    if(board.has_winning_move(color())) {
+        value = POS_INF;
+        return Move::invalid_move();
+    }
+
+    float alpha_start = alpha;
     value = NEG_INF*10;
     Move move = Move::invalid_move();
 
-    int i = copy_killers_to_move_list(depth_bound, board);
-    
-    for(; i < m_potential_moves.size(); ++i) {
-        Move player_move = m_potential_moves[i];
-        if(!board.is_cell_empty(player_move.play_cell(), player_move.play_index())) {
-            i += 7;
-            continue;
-        }
+    MovePicker picker(color(), last_move, depth_bound, hash_move);
 
-        Board new_state = board.clone();
-        new_state.apply_move_no_check(player_move, color());
-        
-        float inner_value = 0.0;
+    if(m_pool && depth_bound >= MIN_SPLIT_DEPTH) {
+        bool cutoff = false;
+        move = search_split(state, board, picker, alpha, beta, true, value, cutoff);
+        store_table(state, board, depth_bound, cutoff ? TranspositionTable::LowerBound :
+                value <= alpha_start ? TranspositionTable::UpperBound :
+                TranspositionTable::ExactBound, value, move);
+        return move;
+    }
 
-        if(depth_bound > 0) { 
-            Move m = minimax_min_value(new_state, depth_bound-1,
-                    alpha, beta, inner_value);
-        } else {
-            inner_value = score_board(new_state);
-            m_node_evals += 1;
-        }
+    Move player_move = Move::invalid_move();
+    for(int i = 0; next_move(state, board, picker, player_move); ++i) {
+        play_move(state, board, player_move, color());
+
+        float inner_value = move_value(state, board, player_move, depth_bound, alpha, beta,
+                true, i == 0);
+
+        take_back_move(state, board, player_move);
 
         if (inner_value > value) {
             value = inner_value;
@@ -428,60 +685,77 @@ Move MinimaxComputerController::minimax_max_value(const Board& board, int depth_
             //is a waste of time.
             
             if(value > 10000) {
+                store_table(state, board, depth_bound, TranspositionTable::LowerBound, value, move);
                 return move;
             }
         }
 
         if(value > beta) {
-            add_killer(depth_bound, player_move);
+            add_killer(state, depth_bound, player_move);
+            add_history(state, color(), depth_bound, last_move, player_move);
+            store_table(state, board, depth_bound, TranspositionTable::LowerBound, value, move);
             return move;
         }
 
         alpha = std::max(alpha, value);
     }
+
+    store_table(state, board, depth_bound, value <= alpha_start ? TranspositionTable::UpperBound :
+            TranspositionTable::ExactBound, value, move);
     return move;
 }
  
 //Minimax function for min levels of the tree. Adapted from the text book description.
-Move MinimaxComputerController::minimax_min_value(const Board& board, int depth_bound,
-        float alpha, float beta, float& value)
+template<typename BoardType>
+Move BasicMinimaxComputerController<BoardType>::minimax_min_value(SearchState& state, BoardType& board,
+        const Move& last_move, int depth_bound, float alpha, float beta, float& value)
 {
-    if(std::clock() - m_search_start_time >= CLOCKS_PER_SEC*m_max_turn_time) {
-        m_time_cancel = true;
+    if(search_stopped(state)) {
         return Move::invalid_move();
     }
 
-    m_node_evals += 1;
-    float board_score = score_board(board);
+    state.node_evals += 1;
+
+    Move hash_move = Move::invalid_move();
+    if(probe_table(board, depth_bound, alpha, beta, value, hash_move)) {
+        return hash_move;
+    }
+
+    float board_score = score_board(board, state.runs);
 
     if(board_score < -1000.0 || board_score > 1000.0) { 
         value = board_score;
         return Move::invalid_move();
     }
 
+    if(board.has_winning_move(opposing_color(color()))) {
+        value = NEG_INF;
+        return Move::invalid_move();
+    }
+
+    float beta_start = beta;
     value = POS_INF*10;
     Move move = Move::invalid_move();
 
-    int i = copy_killers_to_move_list(depth_bound, board);
+    MovePicker picker(opposing_color(color()), last_move, depth_bound, hash_move);
 
-    for(; i < m_potential_moves.size(); ++i) {
-        Move player_move = m_potential_moves[i];
-        if(!board.is_cell_empty(player_move.play_cell(), player_move.play_index())) {
-            i += 7;
-            continue;
-        }
+    if(m_pool && depth_bound >= MIN_SPLIT_DEPTH) {
+        bool cutoff = false;
+        move = search_split(state, board, picker, alpha, beta, false, value, cutoff);
+        store_table(state, board, depth_bound, cutoff ? TranspositionTable::UpperBound :
+                value >= beta_start ? TranspositionTable::LowerBound :
+                TranspositionTable::ExactBound, value, move);
+        return move;
+    }
 
-        Board new_state = board.clone();
-        new_state.apply_move_no_check(player_move, opposing_color(color())); 
+    Move player_move = Move::invalid_move();
+    for(int i = 0; next_move(state, board, picker, player_move); ++i) {
+        play_move(state, board, player_move, opposing_color(color()));
 
-        float inner_value = 0.0;
+        float inner_value = move_value(state, board, player_move, depth_bound, alpha, beta,
+                false, i == 0);
 
-        if(depth_bound > 0) {
-            minimax_max_value(new_state, depth_bound-1, alpha, beta, inner_value);
-        } else {
-            inner_value = score_board(new_state);
-            m_node_evals += 1;
-        }
+        take_back_move(state, board, player_move);
 
         if(inner_value < value) {
             value = inner_value;
@@ -490,51 +764,444 @@ Move MinimaxComputerController::minimax_min_value(const Board& board, int depth_
             //We found a loss. Nothing will score less than it, so searching onward
             //is a waste of time.
             if(value < -100000) {
+                store_table(state, board, depth_bound, TranspositionTable::UpperBound, value, move);
                 return move;
             }
         }
 
         if(value < alpha) {
-            add_killer(depth_bound, player_move);
+            add_killer(state, depth_bound, player_move);
+            add_history(state, opposing_color(color()), depth_bound, last_move, player_move);
+            store_table(state, board, depth_bound, TranspositionTable::UpperBound, value, move);
             return move;
         }
 
         beta = std::min(beta, value);
     }
 
+    store_table(state, board, depth_bound, value >= beta_start ? TranspositionTable::LowerBound :
+            TranspositionTable::ExactBound, value, move);
     return move;
 }
 
-void MinimaxComputerController::add_killer(int depth_bound, Move move)
+//Young brothers wait: search the first move of a node, then queue the others
+//on the pool, each with its own copy of the board, and run tasks until all of
+//them are done. A cutoff cancels the moves still being searched. Sets value
+//to the node's value and cutoff to whether the search ended early, and
+//returns the best move.
+template<typename BoardType>
+Move BasicMinimaxComputerController<BoardType>::search_split(SearchState& state, BoardType& board,
+        MovePicker& picker, float alpha, float beta, bool maximizing, float& value,
+        bool& cutoff)
+{
+    SplitPoint split;
+    split.parent = state.split;
+    split.last_move = picker.last_move;
+    split.mover = picker.mover;
+    split.maximizing = maximizing;
+    split.depth_bound = picker.depth_bound;
+    split.alpha = alpha;
+    split.beta = beta;
+    split.value = maximizing ? NEG_INF*10 : POS_INF*10;
+    split.cutoff = false;
+    split.pending = 0;
+
+    Move eldest_move = Move::invalid_move();
+    if(next_move(state, board, picker, eldest_move)) {
+        split.pending = 1;
+        search_split_move(state, split, board, eldest_move, true);
+    }
+
+    //The younger brothers are only generated if the eldest did not cut off.
+    //They are queued with the best ordered on top, where this thread takes
+    //its next task from.
+    if(!eldest_move.is_invalid() && !split.cutoff && !search_stopped(state)) {
+        std::array<PackedMove, BoardType::MAX_MOVES> younger_moves;
+        int younger_count = 0;
+        Move younger_move = Move::invalid_move();
+        while(next_move(state, board, picker, younger_move)) {
+            younger_moves[younger_count++] = PackedMove(younger_move);
+        }
+
+        split.pending += younger_count;
+        for(int i = younger_count-1; i >= 0; --i) {
+            Move move = younger_moves[i].to_move();
+            m_pool->push(state.thread_index, [this, &split, board, move](int thread_index) mutable {
+                //The thread may be in the middle of a search of its own, so
+                //its runs are moved to the split board and back after.
+                SearchState& thread_state = m_thread_states[thread_index];
+                BasicRunTracker<BoardType> outer_runs = thread_state.runs;
+                thread_state.runs.update(board);
+                search_split_move(thread_state, split, board, move, false);
+                thread_state.runs = outer_runs;
+            });
+        }
+    }
+
+    while(split.pending.load(std::memory_order_acquire) > 0) {
+        if(!m_pool->run_task(state.thread_index)) {
+            std::this_thread::yield();
+        }
+    }
+
+    //Moves cancelled by the clock or a cutoff further up leave the result
+    //incomplete; make sure this node is cancelled as well.
+    search_stopped(state);
+
+    value = split.value;
+    cutoff = split.cutoff;
+    return split.move;
+}
+
+//Search one move of a split point, as a task or as the first move, and add
+//its value to the split point.
+template<typename BoardType>
+void BasicMinimaxComputerController<BoardType>::search_split_move(SearchState& state,
+        SplitPoint& split, BoardType& board, Move move, bool first_move)
+{
+    SplitPoint* outer_split = state.split;
+    bool outer_cancelled = state.cancelled;
+    state.split = &split;
+    state.cancelled = false;
+
+    if(!search_stopped(state)) {
+        float alpha;
+        float beta;
+        {
+            std::lock_guard<std::mutex> lock(split.mutex);
+            alpha = split.alpha;
+            beta = split.beta;
+        }
+
+        play_move(state, board, move, split.mover);
+        float inner_value = move_value(state, board, move, split.depth_bound, alpha, beta,
+                split.maximizing, first_move);
+        take_back_move(state, board, move);
+
+        if(!state.cancelled) {
+            add_split_result(state, split, move, inner_value);
+        }
+    }
+
+    state.split = outer_split;
+    state.cancelled = outer_cancelled;
+
+    //The split point may be gone as soon as the count drops.
+    split.pending.fetch_sub(1, std::memory_order_release);
+}
+
+//Fold the value of a move into its split point, narrowing the window for the
+//moves searched after it, and flag a cutoff the way the serial search would
+//return early.
+template<typename BoardType>
+void BasicMinimaxComputerController<BoardType>::add_split_result(SearchState& state,
+        SplitPoint& split, Move move, float value)
+{
+    std::lock_guard<std::mutex> lock(split.mutex);
+    if(split.cutoff) {
+        return;
+    }
+
+    if(split.maximizing) {
+        if(value > split.value) {
+            split.value = value;
+            split.move = move;
+            if(value > 10000) {
+                split.cutoff = true;
+            }
+        }
+        if(split.value > split.beta) {
+            add_killer(state, split.depth_bound, move);
+            add_history(state, split.mover, split.depth_bound, split.last_move, move);
+            split.cutoff = true;
+        }
+        split.alpha = std::max(split.alpha, split.value);
+    } else {
+        if(value < split.value) {
+            split.value = value;
+            split.move = move;
+            if(value < -100000) {
+                split.cutoff = true;
+            }
+        }
+        if(split.value < split.alpha) {
+            add_killer(state, split.depth_bound, move);
+            add_history(state, split.mover, split.depth_bound, split.last_move, move);
+            split.cutoff = true;
+        }
+        split.beta = std::min(split.beta, split.value);
+    }
+}
+
+//Set move to the next move of the picker's node and return true, or return
+//false once every move has been handed out. The stages are the hash move,
+//the moves that block the opponent's immediate wins, the killers and then
+//the remaining moves, best history first. Immediate wins of the mover need
+//no stage: a node whose mover can win is scored before any moves are
+//generated.
+template<typename BoardType>
+bool BasicMinimaxComputerController<BoardType>::next_move(const SearchState& state,
+        const BoardType& board, MovePicker& picker, Move& move)
+{
+    while(true) {
+        switch(picker.stage) {
+        case MovePicker::HashStage:
+            picker.stage = MovePicker::BlocksStage;
+            if(!picker.hash_move.is_invalid()) {
+                picker.tried[picker.tried_count++] = picker.hash_move;
+                move = picker.hash_move.to_move();
+                return true;
+            }
+            break;
+
+        case MovePicker::BlocksStage:
+            if(picker.move_count < 0) {
+                generate_blocks(state, board, picker);
+            }
+            if(picker.next < picker.move_count) {
+                move = picker.moves[picker.next++].move.to_move();
+                return true;
+            }
+            picker.stage = MovePicker::KillersStage;
+            picker.move_count = -1;
+            picker.next = 0;
+            break;
+
+        case MovePicker::KillersStage:
+            while(picker.next < KILLER_COUNT) {
+                Move killer_move = state.killer_moves[picker.depth_bound*KILLER_COUNT +
+                    picker.next++];
+                if(killer_move.is_invalid() || PackedMove(killer_move) == picker.hash_move ||
+                        !board.is_cell_empty(killer_move.play_cell(), killer_move.play_index())) {
+                    continue;
+                }
+                //Every distinct twist of a block entry was in the blocks stage.
+                int entry = BoardType::entry_index(killer_move.play_cell(),
+                        killer_move.play_index());
+                if(picker.block_entries & (typename BoardType::Mask(1) << entry)) {
+                    continue;
+                }
+                //A killer comes from another position, and may give the same
+                //position here as a move the quiets stage generates.
+                unsigned twists = board.distinct_twists(killer_move.play_cell(),
+                        killer_move.play_index(), picker.mover);
+                if(!(twists & (1u << (killer_move.rotate_cell()*2 +
+                                    killer_move.rotation_direction())))) {
+                    continue;
+                }
+                picker.tried[picker.tried_count++] = PackedMove(killer_move);
+                move = killer_move;
+                return true;
+            }
+            picker.stage = MovePicker::QuietsStage;
+            picker.next = 0;
+            break;
+
+        case MovePicker::QuietsStage:
+            if(picker.move_count < 0) {
+                generate_quiets(state, board, picker);
+            }
+            if(picker.next < picker.move_count) {
+                //Most nodes that cut off do so within a few moves, so the
+                //first few are picked out one at a time and the rest only
+                //sorted when the search gets past them.
+                ScoredMove* moves = picker.moves.data();
+                if(picker.next < QUIET_PICK_COUNT) {
+                    std::iter_swap(moves+picker.next,
+                            std::min_element(moves+picker.next, moves+picker.move_count));
+                } else if(picker.next == QUIET_PICK_COUNT) {
+                    std::sort(moves+picker.next, moves+picker.move_count);
+                }
+                move = moves[picker.next++].move.to_move();
+                return true;
+            }
+            picker.stage = MovePicker::DoneStage;
+            break;
+
+        case MovePicker::DoneStage:
+            return false;
+        }
+    }
+}
+
+//Generate the blocks stage: every distinct move of the mover that plays on an
+//entry where the opponent could win, best history first.
+template<typename BoardType>
+void BasicMinimaxComputerController<BoardType>::generate_blocks(const SearchState& state,
+        const BoardType& board, MovePicker& picker)
+{
+    picker.move_count = 0;
+    picker.next = 0;
+
+    std::array<PackedMove, BoardType::MAX_MOVES> threats;
+    int threat_count = board.generate_threats(picker.mover, threats.data());
+    if(threat_count == 0) {
+        return;
+    }
+
+    PackedMove countermove = countermove_for(state, picker);
+    for(int i = 0; i < threat_count; ++i) {
+        int cell = threats[i].play_cell();
+        int entry = threats[i].play_index();
+        typename BoardType::Mask bit =
+            typename BoardType::Mask(1) << BoardType::entry_index(cell, entry);
+        if(!(picker.block_entries & bit)) {
+            picker.block_entries |= bit;
+            add_entry_moves(state, board, picker, countermove, cell, entry);
+        }
+    }
+
+    std::sort(picker.moves.begin(), picker.moves.begin()+picker.move_count);
+}
+
+//Generate the quiets stage: the distinct moves not handed out by an earlier
+//stage, scored by history, with the countermove to the last move ahead of
+//the rest. Ties keep the order of the static move list. The moves are left
+//unsorted for next_move.
+template<typename BoardType>
+void BasicMinimaxComputerController<BoardType>::generate_quiets(const SearchState& state,
+        const BoardType& board, MovePicker& picker)
+{
+    picker.move_count = 0;
+    picker.next = 0;
+
+    PackedMove countermove = countermove_for(state, picker);
+    typename BoardType::Mask available = board.empty_mask() & ~picker.block_entries;
+    for(const Move& location : m_move_loc_list) {
+        int entry = BoardType::entry_index(location.play_cell(), location.play_index());
+        if(available & (typename BoardType::Mask(1) << entry)) {
+            add_entry_moves(state, board, picker, countermove, location.play_cell(),
+                    location.play_index());
+        }
+    }
+}
+
+//Add the distinct twists of the mover playing at (cell, entry) to the
+//picker's moves, leaving out the hash move and killers already handed out.
+template<typename BoardType>
+void BasicMinimaxComputerController<BoardType>::add_entry_moves(const SearchState& state,
+        const BoardType& board, MovePicker& picker, PackedMove countermove, int cell, int entry)
+{
+    const int* history = &state.history[picker.mover*BoardType::MAX_MOVES];
+    unsigned twists = board.distinct_twists(cell, entry, picker.mover);
+
+    for(int rot_cell = 0; rot_cell < BoardType::CELL_COUNT; ++rot_cell) {
+        for(int dir = RotateLeft; dir <= RotateRight; ++dir) {
+            if(!(twists & (1u << (rot_cell*2 + dir)))) {
+                continue;
+            }
+            PackedMove move(cell, entry, rot_cell, RotationDirection(dir));
+            if(std::find(picker.tried, picker.tried+picker.tried_count, move) !=
+                    picker.tried+picker.tried_count) {
+                continue;
+            }
+
+            ScoredMove& scored = picker.moves[picker.move_count];
+            scored.move = move;
+            scored.score = move == countermove ? COUNTERMOVE_SCORE :
+                history[move_index(move.to_move())];
+            scored.order = picker.move_count;
+            picker.move_count += 1;
+        }
+    }
+}
+
+//The reply of the picker's mover that last cut off after the move leading to
+//the picker's node.
+template<typename BoardType>
+PackedMove BasicMinimaxComputerController<BoardType>::countermove_for(const SearchState& state,
+        const MovePicker& picker)
+{
+    if(picker.last_move.is_invalid()) {
+        return PackedMove::invalid_move();
+    }
+    return state.countermoves[picker.mover*BoardType::MAX_MOVES + move_index(picker.last_move)];
+}
+
+//Look the position up in the transposition table. Set hash_move to the stored
+//best move, and return true with value set if the stored result decides the
+//node for the (alpha, beta) window. Results without a best move are not
+//trusted for cutoffs, so the root always returns a move.
+template<typename BoardType>
+bool BasicMinimaxComputerController<BoardType>::probe_table(const BoardType& board, int depth_bound,
+        float alpha, float beta, float& value, Move& hash_move)
+{
+    TranspositionTable::Entry entry;
+    if(!m_table.probe(board.hash(), entry) || entry.best_move.is_invalid()) {
+        return false;
+    }
+
+    hash_move = entry.best_move.to_move();
+    if(entry.depth < depth_bound) {
+        return false;
+    }
+
+    if(entry.bound == TranspositionTable::ExactBound ||
+            (entry.bound == TranspositionTable::LowerBound && entry.score > beta) ||
+            (entry.bound == TranspositionTable::UpperBound && entry.score < alpha)) {
+        value = entry.score;
+        return true;
+    }
+    return false;
+}
+
+//Record a search result, unless the search was cancelled and the result is
+//incomplete.
+template<typename BoardType>
+void BasicMinimaxComputerController<BoardType>::store_table(const SearchState& state,
+        const BoardType& board, int depth_bound,
+        TranspositionTable::Bound bound, float value, const Move& move)
+{
+    if(state.cancelled) {
+        return;
+    }
+    m_table.store(board.hash(), depth_bound, bound, value,
+            move.is_invalid() ? PackedMove::invalid_move() : PackedMove(move));
+}
+
+template<typename BoardType>
+void BasicMinimaxComputerController<BoardType>::add_killer(SearchState& state, int depth_bound,
+        Move move)
 {
     int killer_start_idx = depth_bound*KILLER_COUNT;
 
     for(int j = 0; j < KILLER_COUNT; ++j) {
-        if(m_killer_moves[killer_start_idx+j] == move) {
+        if(state.killer_moves[killer_start_idx+j] == move) {
           return; 
         }
     }
 
     for(int j = 1; j < KILLER_COUNT; ++j) {
-        m_killer_moves[killer_start_idx+j-1] = m_killer_moves[killer_start_idx+j];
+        state.killer_moves[killer_start_idx+j-1] = state.killer_moves[killer_start_idx+j];
     }
 
-    m_killer_moves[killer_start_idx+KILLER_COUNT-1] = move;
+    state.killer_moves[killer_start_idx+KILLER_COUNT-1] = move;
 }
  
-int MinimaxComputerController::copy_killers_to_move_list(int depth_bound, const Board& board)
+//Credit a move that caused a cutoff for mover at depth_bound in the history
+//table, deeper cutoffs counting for more, and make it the countermove to
+//last_move.
+template<typename BoardType>
+void BasicMinimaxComputerController<BoardType>::add_history(SearchState& state, PlayerColor mover,
+        int depth_bound, const Move& last_move, const Move& move)
 {
-    int first_move = 0;
-    for(int j = 0; j < KILLER_COUNT; ++j) {
-        Move killer_move = m_killer_moves[depth_bound*KILLER_COUNT+j];
-        if(!killer_move.is_invalid() && 
-                board.is_cell_empty(killer_move.play_cell(),
-                killer_move.play_index())) {
-            m_potential_moves[j] = killer_move;
-        } else {
-            first_move = j+1;
-        }
+    int& score = state.history[mover*BoardType::MAX_MOVES + move_index(move)];
+    score = std::min(score + (depth_bound+1)*(depth_bound+1), HISTORY_MAX);
+
+    if(!last_move.is_invalid()) {
+        state.countermoves[mover*BoardType::MAX_MOVES + move_index(last_move)] = PackedMove(move);
     }
+}
 
-    return first_move;
+//Halve every history score, so cutoffs found at the depth being searched
+//outweigh those of earlier depths.
+template<typename BoardType>
+void BasicMinimaxComputerController<BoardType>::age_history(SearchState& state)
+{
+    for(int& score : state.history) {
+        score /= 2;
+    }
 }
+
+template class BasicMinimaxComputerController<Board>;
+template class BasicMinimaxComputerController<LargeBoard>;
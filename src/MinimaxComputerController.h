@@ -5,66 +5,296 @@
 
 
 #include "PlayerController.h"
+#include "TranspositionTable.h"
+#include "RunTracker.h"
+#include "WorkStealingPool.h"
+#include "TimeManager.h"
 
 #include <string>
 #include <vector>
 #include <array>
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <memory>
+#include <thread>
 
-class MinimaxComputerController: public PlayerController
+template<typename BoardType>
+class BasicMinimaxComputerController: public BasicPlayerController<BoardType>
 {
 public:
-    MinimaxComputerController(std::string name, PlayerColor color, 
-            const Board& board, int max_depth, float max_turn_time);
-    ~MinimaxComputerController();
+    //How the search uses more than one thread.
+    enum ParallelMode {
+        //Helper threads run their own searches and share results through the
+        //transposition table.
+        LazySmp,
+        //Nodes deep enough search their first move, then hand the rest to a
+        //work stealing pool of threads.
+        YoungBrothersWait
+    };
 
-    virtual Move make_move(const Board& board, const Pentago& game);
+    //table_size_mb sets the size of the transposition table. parallel_mode
+    //picks how threads beyond the first are used. A positive game_time is the
+    //time for all of the controller's moves in the game, on top of the
+    //max_turn_time limit on each.
+    BasicMinimaxComputerController(std::string name, PlayerColor color, 
+            const BoardType& board, int max_depth, float max_turn_time,
+            int table_size_mb = 16, int thread_count = 1,
+            ParallelMode parallel_mode = LazySmp, float game_time = 0.0);
+    ~BasicMinimaxComputerController();
+
+    virtual Move make_move(const BoardType& board, const BasicPentago<BoardType>& game);
+
+    //With pondering enabled, the controller keeps searching after its move,
+    //on the position after the reply it expects. If the opponent plays it,
+    //the next make_move carries on with that search instead of starting over.
+    virtual void opponent_moved(const BoardType& board, const Move& move);
+
+    //Depth completed, nodes evaluated over all threads and wall clock time
+    //taken by the last make_move.
+    int last_depth() const {return m_last_depth;}
+    long long last_node_evals() const {return m_last_node_evals;}
+    double last_search_time() const {return m_last_search_time;}
+
+    //The main search thread's killers for remaining depth depth_bound, oldest
+    //first.
+    std::vector<Move> killers(int depth_bound) const;
 
 private:
+    using BasicPlayerController<BoardType>::color;
+    using BasicPlayerController<BoardType>::player_win_kind;
+
     static const int BEST_RUN_COUNT = 3;
+    static const int KILLER_COUNT = 4;
 
-    void find_runs(const Board& board, std::array<int, BEST_RUN_COUNT>& player_runs,
-            std::array<int, BEST_RUN_COUNT>& opponent_runs);
+    //Remaining depth from which nodes split their moves over the pool.
+    static const int MIN_SPLIT_DEPTH = 2;
+
+    //A node whose moves after the first are searched in parallel. Lives on
+    //the stack of the thread that split it, which waits for all of its moves.
+    struct SplitPoint
+    {
+        SplitPoint(): last_move(Move::invalid_move()), move(Move::invalid_move()) {}
+
+        SplitPoint* parent;
+        Move last_move;
+        PlayerColor mover;
+        bool maximizing;
+        int depth_bound;
+
+        //The window and best result so far, guarded by mutex.
+        std::mutex mutex;
+        float alpha;
+        float beta;
+        float value;
+        Move move;
+
+        std::atomic<int> pending;
+        std::atomic<bool> cutoff;
+    };
+
+    //Search state owned by a single thread.
+    struct SearchState
+    {
+        SearchState(): thread_index(0), history(2*BoardType::MAX_MOVES, 0),
+            countermoves(2*BoardType::MAX_MOVES), node_evals(0), cancelled(false),
+            time_check_countdown(0), split(nullptr) {}
+
+        int thread_index;
+        std::vector<Move> killer_moves;
+
+        //History scores of moves and the countermove to each move, both
+        //indexed by color*MAX_MOVES + move_index(move). The countermove is
+        //the last reply by color that caused a cutoff.
+        std::vector<int> history;
+        std::vector<PackedMove> countermoves;
+
+        //Runs on the board being searched, updated by play_move and put back
+        //from saved_runs by take_back_move.
+        BasicRunTracker<BoardType> runs;
+        std::vector<BasicRunTracker<BoardType>> saved_runs;
+
+        long long node_evals;
+        bool cancelled;
+        int time_check_countdown;
+
+        //The innermost split point the thread is searching a move of. A
+        //cutoff at it or any of its parents cancels the thread's search.
+        SplitPoint* split;
+    };
+
+    //Moves for one play position, one per twist of each cell.
+    static const int MOVES_PER_ENTRY = BoardType::CELL_COUNT*2;
+
+    //A move with its ordering score. Sorts by descending score, then by
+    //ascending order.
+    struct ScoredMove
+    {
+        PackedMove move;
+        int score;
+        int order;
+
+        bool operator <(const ScoredMove& other) const
+        {
+            return score > other.score || (score == other.score && order < other.order);
+        }
+    };
 
-    void add_run(std::array<int, BEST_RUN_COUNT>& player_runs,
-            std::array<int, BEST_RUN_COUNT>& opponent_runs,
-            int run_len, BoardEntry entry_kind);
+    //The moves of a node, handed out by next_move in stages. Each stage is
+    //only generated once the moves before it failed to cut off.
+    struct MovePicker
+    {
+        enum Stage {
+            HashStage,
+            BlocksStage,
+            KillersStage,
+            QuietsStage,
+            DoneStage
+        };
 
-    void build_static_move_list(const Board& board);
+        MovePicker(PlayerColor mover_color, const Move& node_last_move, int node_depth_bound,
+                const Move& node_hash_move):
+            stage(HashStage), mover(mover_color), last_move(node_last_move),
+            depth_bound(node_depth_bound), hash_move(node_hash_move), block_entries(0),
+            tried_count(0), move_count(-1), next(0) {}
 
-    float score_board(const Board& board);
+        Stage stage;
+        PlayerColor mover;
+        Move last_move;
+        int depth_bound;
+        PackedMove hash_move;
 
-    void center_control_scores(const Board& board, float& player_score,
+        //Entries played by the blocks stage, which hands out all of their
+        //distinct twists, and the hash move and killers handed out.
+        typename BoardType::Mask block_entries;
+        PackedMove tried[KILLER_COUNT+1];
+        int tried_count;
+
+        //Moves of the current stage, generated on entering it. move_count is
+        //-1 until then.
+        std::array<ScoredMove, BoardType::MAX_MOVES> moves;
+        int move_count;
+        int next;
+    };
+
+    //Dense index of a move, below MAX_MOVES.
+    static int move_index(const Move& move)
+    {
+        return BoardType::entry_index(move.play_cell(), move.play_index())*MOVES_PER_ENTRY +
+            move.rotate_cell()*2 + move.rotation_direction();
+    }
+
+    void find_runs(const BasicRunTracker<BoardType>& runs,
+            std::array<int, BEST_RUN_COUNT>& player_runs,
+            std::array<int, BEST_RUN_COUNT>& opponent_runs);
+
+    void build_static_move_list(const BoardType& board);
+
+    float score_board(const BoardType& board);
+    float score_board(const BoardType& board, const BasicRunTracker<BoardType>& runs);
+
+    void center_control_scores(const BoardType& board, float& player_score,
             float& opponent_score);
 
     float run_score(const std::array<int, BEST_RUN_COUNT>& runs);
-    void run_scores(const Board& board, float& player_score, float& opponent_score);
+    void run_scores(const BasicRunTracker<BoardType>& runs, float& player_score,
+            float& opponent_score);
+
+    Move search(const BoardType& board);
+    void helper_search(SearchState& state, BoardType board, int thread_index);
+
+    void save_principal_variation(const BoardType& board, int depth);
+    void seed_principal_variation(const BoardType& board);
 
-    Move minimax_2(const Board& board, int depth_bound, float& max);
-    Move minimax_max_value(const Board& board, int depth_bound, float alpha, float beta, 
-            float& value);
-    Move minimax_min_value(const Board& board, int depth_bound, float alpha, float beta, 
-            float& value);
+    void start_pondering(const BoardType& board, const Move& move);
+    void stop_pondering();
+    static bool same_position(const BoardType& board, const BoardType& other);
 
-    void add_killer(int depth_bound, Move move);
-    int copy_killers_to_move_list(int depth_bound, const Board& board);
+    bool search_stopped(SearchState& state);
 
-    std::vector<Move> m_potential_moves;
+    //Apply and undo a move on board in place, keeping state's runs up to date.
+    void play_move(SearchState& state, BoardType& board, const Move& move, PlayerColor mover);
+    void take_back_move(SearchState& state, BoardType& board, const Move& move);
+
+    //The search functions apply and undo moves on board in place.
+    Move minimax_2(SearchState& state, BoardType& board, int depth_bound, float alpha,
+            float beta, float& max);
+    float move_value(SearchState& state, BoardType& board, const Move& move, int depth_bound,
+            float alpha, float beta, bool maximizing, bool first_move);
+    Move minimax_max_value(SearchState& state, BoardType& board, const Move& last_move,
+            int depth_bound, float alpha, float beta, float& value);
+    Move minimax_min_value(SearchState& state, BoardType& board, const Move& last_move,
+            int depth_bound, float alpha, float beta, float& value);
+
+    Move search_split(SearchState& state, BoardType& board, MovePicker& picker,
+            float alpha, float beta, bool maximizing, float& value, bool& cutoff);
+    void search_split_move(SearchState& state, SplitPoint& split, BoardType& board,
+            Move move, bool first_move);
+    void add_split_result(SearchState& state, SplitPoint& split, Move move, float value);
+    bool next_move(const SearchState& state, const BoardType& board, MovePicker& picker,
+            Move& move);
+    void generate_blocks(const SearchState& state, const BoardType& board,
+            MovePicker& picker);
+    void generate_quiets(const SearchState& state, const BoardType& board,
+            MovePicker& picker);
+    void add_entry_moves(const SearchState& state, const BoardType& board,
+            MovePicker& picker, PackedMove countermove, int cell, int entry);
+    PackedMove countermove_for(const SearchState& state, const MovePicker& picker);
+
+    void add_killer(SearchState& state, int depth_bound, Move move);
+    void add_history(SearchState& state, PlayerColor mover, int depth_bound,
+            const Move& last_move, const Move& move);
+    void age_history(SearchState& state);
+    bool probe_table(const BoardType& board, int depth_bound, float alpha, float beta,
+            float& value, Move& hash_move);
+    void store_table(const SearchState& state, const BoardType& board, int depth_bound,
+            TranspositionTable::Bound bound, float value, const Move& move);
+
+    //Every play position, in the order the quiets stage tries them.
     std::vector<Move> m_move_loc_list;
 
-    std::vector<Move> m_killer_moves;
+    TranspositionTable m_table;
 
     float m_coeff_center_control;
     float m_coeff_longest_run;
 
     int m_max_depth;
-    float m_max_turn_time;
+    int m_thread_count;
+    ParallelMode m_parallel_mode;
+
+    //Kept from one search to the next, along with the transposition table.
+    std::vector<SearchState> m_thread_states;
 
-    int m_node_evals;
+    //Threads of a young brothers wait search, only while one runs. Idle pool
+    //threads spin, so a pool kept between moves would take cores from the
+    //opponent.
+    std::unique_ptr<WorkStealingPool> m_pool;
 
-    clock_t m_search_start_time;
-    bool m_time_cancel;
+    int m_last_depth;
+    float m_last_score;
+    long long m_last_node_evals;
+    double m_last_search_time;
+
+    //The principal variation of the last search, from m_pv_board.
+    BoardType m_pv_board;
+    std::vector<Move> m_principal_variation;
+
+    TimeManager m_time;
+    std::atomic<bool> m_stop_search;
+
+    //The ponder search runs on its own thread, on m_ponder_board, with no
+    //time limit while m_pondering is set.
+    std::thread m_ponder_thread;
+    std::atomic<bool> m_pondering;
+    BoardType m_ponder_board;
+    Move m_ponder_move;
+    std::chrono::steady_clock::time_point m_ponder_start;
 };
 
+typedef BasicMinimaxComputerController<Board> MinimaxComputerController;
+
+extern template class BasicMinimaxComputerController<Board>;
+extern template class BasicMinimaxComputerController<LargeBoard>;
 
 #endif
     
@@ -3,6 +3,7 @@
 
 #include <ostream>
 #include <istream>
+#include <cstdint>
 
 #include "Enums.h"
 
@@ -40,6 +41,43 @@ private:
     RotationDirection m_direction;
 };
 
+//A Move packed into 16 bits: the play index in bits 0-3, the play cell in
+//bits 4-7, the rotated cell in bits 8-11 and the direction in bit 12. The
+//encoding does not depend on the board geometry, so conversion to and from
+//Move is lossless for any board with at most 16 cells of 16 entries.
+class PackedMove
+{
+public:
+    PackedMove(): m_bits(INVALID_BITS) {}
+    PackedMove(int cell, int index, int rotate_cell, RotationDirection dir);
+    explicit PackedMove(const Move& move);
+
+    int play_cell() const {return (m_bits >> 4) & 0xF;}
+    int play_index() const {return m_bits & 0xF;}
+    int rotate_cell() const {return (m_bits >> 8) & 0xF;}
+    RotationDirection rotation_direction() const
+        {return static_cast<RotationDirection>((m_bits >> 12) & 1);}
+
+    bool is_invalid() const {return m_bits == INVALID_BITS;}
+
+    Move to_move() const;
+
+    std::uint16_t bits() const {return m_bits;}
+
+    bool operator ==(const PackedMove& other) const {return m_bits == other.m_bits;}
+    bool operator !=(const PackedMove& other) const {return m_bits != other.m_bits;}
+
+    static PackedMove invalid_move() {return PackedMove();}
+
+    //Rebuild a move from the value returned by bits().
+    static PackedMove from_bits(std::uint16_t bits) {PackedMove move; move.m_bits = bits; return move;}
+
+private:
+    static const std::uint16_t INVALID_BITS = 0xFFFF;
+
+    std::uint16_t m_bits;
+};
+
 inline bool Move::is_invalid() const
 {
     return m_cell == -1; 
@@ -63,5 +101,27 @@ inline bool Move::operator!=(const Move& other) const
     return !(*this == other); 
 }
  
+inline PackedMove::PackedMove(int cell, int index, int rotate_cell, RotationDirection dir):
+    m_bits(index | (cell << 4) | (rotate_cell << 8) | (dir << 12))
+{
+}
+
+inline PackedMove::PackedMove(const Move& move):
+    m_bits(INVALID_BITS)
+{
+    if(!move.is_invalid()) {
+        *this = PackedMove(move.play_cell(), move.play_index(), move.rotate_cell(),
+                move.rotation_direction());
+    }
+}
+
+inline Move PackedMove::to_move() const
+{
+    if(is_invalid()) {
+        return Move::invalid_move();
+    }
+    return Move(play_cell(), play_index(), rotate_cell(), rotation_direction()); 
+}
+
 #endif
     
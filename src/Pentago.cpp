@@ -8,13 +8,15 @@
 #include "HumanPlayerController.h"
 #include "ControllerFactory.h"
 
-Pentago::Pentago(Board board, PlayerController* player1, PlayerController* player2):
+template<typename BoardType>
+BasicPentago<BoardType>::BasicPentago(BoardType board, PlayerController* player1, PlayerController* player2):
     m_board(board), m_current_player(player1), m_next_player(player2)
 {
  
 }
  
-Pentago::~Pentago()
+template<typename BoardType>
+BasicPentago<BoardType>::~BasicPentago()
 {
     delete m_current_player;
     delete m_next_player; 
@@ -22,7 +24,8 @@ Pentago::~Pentago()
 
 
  
-WinStatus Pentago::play_game()
+template<typename BoardType>
+WinStatus BasicPentago<BoardType>::play_game()
 {
     //First, display the starting board
     std::cout << m_board;
@@ -46,6 +49,7 @@ WinStatus Pentago::play_game()
         //checked in the while condition.
         WinStatus pre_twist_win =
             m_board.apply_move(move, m_current_player->color());
+        m_next_player->opponent_moved(m_board, move);
 
         if(pre_twist_win != NoWin) {
             return pre_twist_win;
@@ -67,7 +71,8 @@ WinStatus Pentago::play_game()
     return m_board.check_for_wins();
 }
  
-void Pentago::serialize_state(std::ostream& stream)
+template<typename BoardType>
+void BasicPentago<BoardType>::serialize_state(std::ostream& stream)
 {
     //Serialize the player data
     stream << m_current_player->name() << "\n";
@@ -104,7 +109,8 @@ PlayerColor char_to_color(char ch) {
     }
 }
  
-Pentago* Pentago::load_game(std::istream& in_stream, const ControllerFactory& factory)
+template<typename BoardType>
+BasicPentago<BoardType>* BasicPentago<BoardType>::load_game(std::istream& in_stream, const ControllerFactory& factory)
 {
     std::string player1_name;
     std::string player2_name;
@@ -144,7 +150,7 @@ Pentago* Pentago::load_game(std::istream& in_stream, const ControllerFactory& fa
     //Ignore all characters up to the new line so getline starts with the board data.
     in_stream.ignore(1000, '\n');
 
-    Board board;
+    BoardType board;
     //Read in the board state
     for(int i = 0; i < board.board_size(); ++i) {
         std::string line;
@@ -170,7 +176,7 @@ Pentago* Pentago::load_game(std::istream& in_stream, const ControllerFactory& fa
         std::swap(player1, player2);
     }
 
-    Pentago* game = new Pentago(board, player1, player2);
+    BasicPentago* game = new BasicPentago(board, player1, player2);
 
     //Read in the list of past moves
     while(in_stream.good()) {
@@ -185,12 +191,14 @@ Pentago* Pentago::load_game(std::istream& in_stream, const ControllerFactory& fa
     return game;
 }
  
-PlayerController* Pentago::get_player_from_color(PlayerColor color)
+template<typename BoardType>
+typename BasicPentago<BoardType>::PlayerController* BasicPentago<BoardType>::get_player_from_color(PlayerColor color)
 {
     return m_current_player->color() == color ? m_current_player : m_next_player;
 }
  
-void Pentago::save_state()
+template<typename BoardType>
+void BasicPentago<BoardType>::save_state()
 {
     std::ofstream save_file(m_save_state_file_name.c_str());
 
@@ -199,7 +207,8 @@ void Pentago::save_state()
     }
 }
  
-std::string Pentago::color_to_serial_str(PlayerColor color)
+template<typename BoardType>
+std::string BasicPentago<BoardType>::color_to_serial_str(PlayerColor color)
 {
     if(color == WhitePlayer) {
         return "W";
@@ -210,7 +219,8 @@ std::string Pentago::color_to_serial_str(PlayerColor color)
     }
 }
  
-bool Pentago::is_valid_move(const Move& move) const
+template<typename BoardType>
+bool BasicPentago<BoardType>::is_valid_move(const Move& move) const
 {
     //Check for out of bound or invalid values.
     if(move.play_cell() < 0 || move.play_cell() >= m_board.cell_count()) {
@@ -232,4 +242,6 @@ bool Pentago::is_valid_move(const Move& move) const
     }
     return true;
 }
- 
+
+template class BasicPentago<Board>;
+template class BasicPentago<LargeBoard>;
@@ -10,32 +10,37 @@
 #include "PlayerController.h"
 #include "Enums.h"
 
-class ControllerFactory;
+template<typename BoardType> class BasicControllerFactory;
 
-class Pentago
+//A game between two controllers on a board of the given geometry.
+template<typename BoardType>
+class BasicPentago
 {
 public:
-    Pentago(Board board, PlayerController* player1, PlayerController* player2);
-    ~Pentago();
+    typedef BasicPlayerController<BoardType> PlayerController;
+    typedef BasicControllerFactory<BoardType> ControllerFactory;
+
+    BasicPentago(BoardType board, PlayerController* player1, PlayerController* player2);
+    ~BasicPentago();
 
     WinStatus play_game();
 
     void serialize_state(std::ostream& stream);
 
-    const Board& board() const {return m_board;}
+    const BoardType& board() const {return m_board;}
 
     void set_save_file(std::string file_name) {m_save_state_file_name = file_name;}
 
     void swap_payers();
 
-    static Pentago* load_game(std::istream& in_stream, const ControllerFactory& factory);
+    static BasicPentago* load_game(std::istream& in_stream, const ControllerFactory& factory);
 
     PlayerController* get_current_player() {return m_current_player;}
     PlayerController* get_next_player() {return m_next_player;}
     PlayerController* get_player_from_color(PlayerColor color);
 
 protected:
-    Board m_board;
+    BoardType m_board;
 
     PlayerController* m_current_player;
     PlayerController* m_next_player;
@@ -52,10 +57,16 @@ private:
 };
 
 
-inline void Pentago::swap_payers()
+typedef BasicPentago<Board> Pentago;
+
+template<typename BoardType>
+inline void BasicPentago<BoardType>::swap_payers()
 {
     std::swap(m_current_player, m_next_player); 
 }
+
+extern template class BasicPentago<Board>;
+extern template class BasicPentago<LargeBoard>;
  
 #endif
     
@@ -1,8 +1,12 @@
 #include "PlayerController.h"
 
-PlayerController::PlayerController(std::string name, PlayerColor color):
-    m_name(name), m_color(color)
+template<typename BoardType>
+BasicPlayerController<BoardType>::BasicPlayerController(std::string name, PlayerColor color):
+    m_name(name), m_color(color), m_pondering_enabled(false)
 {
  
 }
+
+template class BasicPlayerController<Board>;
+template class BasicPlayerController<LargeBoard>;
  
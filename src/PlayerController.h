@@ -8,14 +8,16 @@
 
 #include "Enums.h"
 
-class Board;
-class Pentago;
+template<typename BoardType> class BasicPentago;
 
-class PlayerController
+//Base class of everything that can choose moves, templated on the board
+//geometry it plays on.
+template<typename BoardType>
+class BasicPlayerController
 {
 public:
-    PlayerController(std::string name, PlayerColor color);
-    ~PlayerController() {};
+    BasicPlayerController(std::string name, PlayerColor color);
+    virtual ~BasicPlayerController() {};
 
     const std::string& name() const {return m_name;}
     PlayerColor color() const {return m_color;}
@@ -24,17 +26,30 @@ public:
     int kind_id() const {return m_controller_id;}
     void set_kind_id(int value) {m_controller_id = value;}
 
-    virtual Move make_move(const Board& board, const Pentago& game) = 0;
+    virtual Move make_move(const BoardType& board, const BasicPentago<BoardType>& game) = 0;
+
+    //Called by the game once the opponent's move has been applied to board,
+    //before this controller is asked for its reply.
+    virtual void opponent_moved(const BoardType& board, const Move& move) {}
+
+    //Whether the controller may go on thinking during the opponent's turn.
+    //Only controllers that search do anything with it.
+    bool pondering_enabled() const {return m_pondering_enabled;}
+    void set_pondering(bool enabled) {m_pondering_enabled = enabled;}
 
 protected:
 private:
     std::string m_name;
     PlayerColor m_color;
     int m_controller_id;
+    bool m_pondering_enabled;
 };
 
+typedef BasicPlayerController<Board> PlayerController;
 
-inline WinStatus PlayerController::player_win_kind() const
+
+template<typename BoardType>
+inline WinStatus BasicPlayerController<BoardType>::player_win_kind() const
 {
     if(m_color == BlackPlayer) {
        return BlackWin;
@@ -42,6 +57,9 @@ inline WinStatus PlayerController::player_win_kind() const
        return WhiteWin;
     } 
 }
+
+extern template class BasicPlayerController<Board>;
+extern template class BasicPlayerController<LargeBoard>;
  
 #endif
     
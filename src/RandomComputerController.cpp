@@ -8,18 +8,21 @@
 
 
 
-RandomComputerController::RandomComputerController(std::string name, PlayerColor color):
-    PlayerController(name, color)
+template<typename BoardType>
+BasicRandomComputerController<BoardType>::BasicRandomComputerController(std::string name, PlayerColor color):
+    BasicPlayerController<BoardType>(name, color)
 {
  
 }
  
-RandomComputerController::~RandomComputerController()
+template<typename BoardType>
+BasicRandomComputerController<BoardType>::~BasicRandomComputerController()
 {
  
 }
  
-Move RandomComputerController::make_move(const Board& board, const Pentago& game)
+template<typename BoardType>
+Move BasicRandomComputerController<BoardType>::make_move(const BoardType& board, const BasicPentago<BoardType>& game)
 {
     int cell = 0;
     int entry = 0;
@@ -41,4 +44,6 @@ Move RandomComputerController::make_move(const Board& board, const Pentago& game
 
     return Move(cell, entry, rotate_cell, dir);
 }
- 
+
+template class BasicRandomComputerController<Board>;
+template class BasicRandomComputerController<LargeBoard>;
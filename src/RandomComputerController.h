@@ -3,18 +3,23 @@
 
 #include "PlayerController.h"
 
-class RandomComputerController: public PlayerController
+template<typename BoardType>
+class BasicRandomComputerController: public BasicPlayerController<BoardType>
 {
 public:
-    RandomComputerController(std::string name, PlayerColor color);
-    ~RandomComputerController();
+    BasicRandomComputerController(std::string name, PlayerColor color);
+    ~BasicRandomComputerController();
 
-    virtual Move make_move(const Board& board, const Pentago& game);
+    virtual Move make_move(const BoardType& board, const BasicPentago<BoardType>& game);
 
 protected:
 private:
 };
 
+typedef BasicRandomComputerController<Board> RandomComputerController;
+
+extern template class BasicRandomComputerController<Board>;
+extern template class BasicRandomComputerController<LargeBoard>;
 
 #endif
     
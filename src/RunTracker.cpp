@@ -0,0 +1,290 @@
+#include "RunTracker.h"
+
+#include <algorithm>
+
+template<typename BoardType>
+BasicRunTracker<BoardType>::BasicRunTracker()
+{
+    reset(BoardType());
+}
+
+template<typename BoardType>
+BasicRunTracker<BoardType>::BasicRunTracker(const BoardType& board)
+{
+    reset(board);
+}
+
+//Lines run in the direction of the evaluation's scans: rows left to right,
+//columns top to bottom, diagonals down-right and anti-diagonals up-right.
+//Every entry lies on exactly one line of each.
+template<typename BoardType>
+constexpr void BasicRunTracker<BoardType>::add_line(Tables& tables, int line_index, int x, int y,
+        int dx, int dy, int direction)
+{
+    const int CELL_SIZE = BoardType::CELL_SIZE;
+
+    int digit = 1;
+    tables.line_direction[line_index] = direction;
+    for(int place = 0; x >= 0 && x < SIZE && y >= 0 && y < SIZE; x += dx, y += dy, ++place) {
+        int cell = (x / CELL_SIZE) + (y / CELL_SIZE) * BoardType::CELLS_PER_ROW;
+        int entry = (x % CELL_SIZE) + (y % CELL_SIZE) * CELL_SIZE;
+        int index = BoardType::entry_index(cell, entry);
+        tables.entry_line[index][direction] = line_index;
+        tables.entry_digit[index][direction] = digit;
+        tables.line_position[line_index][place] = x + y*SIZE;
+        digit *= 3;
+    }
+}
+
+template<typename BoardType>
+constexpr typename BasicRunTracker<BoardType>::Tables BasicRunTracker<BoardType>::build_tables()
+{
+    Tables tables = {};
+
+    int line_count = 0;
+    for(int i = 0; i < SIZE; ++i) {
+        add_line(tables, line_count++, 0, i, 1, 0, 0);
+        add_line(tables, line_count++, i, 0, 0, 1, 1);
+        add_line(tables, line_count++, 0, i, 1, 1, 2);
+        add_line(tables, line_count++, 0, i, 1, -1, 3);
+    }
+    for(int i = 1; i < SIZE; ++i) {
+        add_line(tables, line_count++, i, 0, 1, 1, 2);
+        add_line(tables, line_count++, i, SIZE-1, 1, -1, 3);
+    }
+
+    //The same scan as the full evaluation: from each stone, count its color
+    //over the next MAX_RUN entries, skipping empties and stopping at the
+    //first opposing stone.
+    for(int pattern = 0; pattern < PATTERN_COUNT; ++pattern) {
+        int entries[SIZE] = {};
+        for(int i = 0, rest = pattern; i < SIZE; ++i, rest /= 3) {
+            entries[i] = rest % 3;
+        }
+
+        std::uint64_t places = 0;
+        for(int i = 0; i < SIZE; ++i) {
+            if(entries[i] == EmptyEntry) {
+                continue;
+            }
+
+            int run_len = 0;
+            for(int j = i+1; j < SIZE && j <= i + MAX_RUN; ++j) {
+                if(entries[j] == entries[i]) {
+                    ++run_len;
+                } else if(entries[j] != EmptyEntry) {
+                    break;
+                }
+            }
+            if(run_len > 0) {
+                tables.pattern_runs[pattern][entries[i] == WhiteEntry ? WhitePlayer : BlackPlayer] +=
+                    PackedRuns(1) << ((run_len-1)*16);
+                places |= std::uint64_t(run_len | (entries[i] == BlackEntry ? BLACK_PLACE_BIT : 0))
+                    << (i*PLACE_BITS);
+            }
+        }
+        tables.pattern_places[pattern] = places;
+    }
+
+    return tables;
+}
+
+template<typename BoardType>
+constexpr typename BasicRunTracker<BoardType>::Tables BasicRunTracker<BoardType>::s_tables = build_tables();
+
+template<typename BoardType>
+void BasicRunTracker<BoardType>::reset(const BoardType& board)
+{
+    m_white_mask = 0;
+    m_black_mask = 0;
+    m_patterns.fill(0);
+    m_runs[WhitePlayer] = 0;
+    m_runs[BlackPlayer] = 0;
+    std::fill(&m_run_starts[0][0][0], &m_run_starts[0][0][0] + 4*2*(MAX_RUN+1), Mask(0));
+
+    update(board);
+}
+
+//Take the runs of each line touched out of the totals, move its pattern by
+//the change in each of its entries' digits, then add the new runs back in
+//and move the starts of the runs that changed.
+template<typename BoardType>
+void BasicRunTracker<BoardType>::update(const BoardType& board)
+{
+    Mask white_mask = board.white_mask();
+    Mask black_mask = board.black_mask();
+    Mask changed = (white_mask ^ m_white_mask) | (black_mask ^ m_black_mask);
+
+    std::uint64_t touched_lines = 0;
+    std::uint16_t old_patterns[LINE_COUNT];
+    for(; changed; changed &= changed - 1) {
+        int index = BoardType::lowest_entry(changed);
+        int old_value = int((m_white_mask >> index) & 1) + 2*int((m_black_mask >> index) & 1);
+        int new_value = int((white_mask >> index) & 1) + 2*int((black_mask >> index) & 1);
+
+        for(int i = 0; i < 4; ++i) {
+            int line = s_tables.entry_line[index][i];
+            std::uint64_t line_bit = std::uint64_t(1) << line;
+            if(!(touched_lines & line_bit)) {
+                touched_lines |= line_bit;
+                old_patterns[line] = m_patterns[line];
+            }
+            m_patterns[line] += (new_value - old_value)*s_tables.entry_digit[index][i];
+        }
+    }
+
+    m_white_mask = white_mask;
+    m_black_mask = black_mask;
+
+    const std::uint64_t PLACE_MASK = (std::uint64_t(1) << PLACE_BITS) - 1;
+    for(; touched_lines; touched_lines &= touched_lines - 1) {
+        int line = __builtin_ctzll(touched_lines);
+        int old_pattern = old_patterns[line];
+        int new_pattern = m_patterns[line];
+        m_runs[WhitePlayer] += s_tables.pattern_runs[new_pattern][WhitePlayer] -
+            s_tables.pattern_runs[old_pattern][WhitePlayer];
+        m_runs[BlackPlayer] += s_tables.pattern_runs[new_pattern][BlackPlayer] -
+            s_tables.pattern_runs[old_pattern][BlackPlayer];
+
+        Mask (&starts)[2][MAX_RUN+1] = m_run_starts[s_tables.line_direction[line]];
+        std::uint64_t old_places = s_tables.pattern_places[old_pattern];
+        std::uint64_t new_places = s_tables.pattern_places[new_pattern];
+        for(std::uint64_t diff = old_places ^ new_places; diff;) {
+            int place = __builtin_ctzll(diff) / PLACE_BITS;
+            diff &= ~(PLACE_MASK << (place*PLACE_BITS));
+            Mask bit = Mask(1) << s_tables.line_position[line][place];
+
+            int old_run = (old_places >> (place*PLACE_BITS)) & PLACE_MASK;
+            int new_run = (new_places >> (place*PLACE_BITS)) & PLACE_MASK;
+            starts[old_run >= BLACK_PLACE_BIT][old_run & ~BLACK_PLACE_BIT] &= ~bit;
+            starts[new_run >= BLACK_PLACE_BIT][new_run & ~BLACK_PLACE_BIT] |= bit;
+        }
+    }
+}
+
+template<typename BoardType>
+void BasicRunTracker<BoardType>::best_runs(PlayerColor color, int* runs, int count) const
+{
+    int found = 0;
+    for(int len = MAX_RUN; len > 0 && found < count; --len) {
+        int len_count = (m_runs[color] >> ((len-1)*16)) & 0xFFFF;
+        for(int i = 0; i < len_count && found < count; ++i) {
+            runs[found++] = len;
+        }
+    }
+    std::fill(runs + found, runs + count, 0);
+}
+
+template<typename BoardType>
+inline int BasicRunTracker<BoardType>::highest_position(Mask mask)
+{
+    if constexpr(sizeof(Mask) <= sizeof(unsigned long long)) {
+        return 63 - __builtin_clzll(mask);
+    } else {
+        std::uint64_t high = static_cast<std::uint64_t>(mask >> 64);
+        if(high) {
+            return 127 - __builtin_clzll(high);
+        }
+        return 63 - __builtin_clzll(static_cast<std::uint64_t>(mask));
+    }
+}
+
+//Rather than replaying the scan, work out what its order decides. Scan times
+//are direction*SIZE*SIZE + position. An opponent's run of length len is
+//taken until the player's third run of at least len, and the opponent's
+//first two are the top two of the runs taken. Every run taken writes the
+//third: the smaller of its length and the second of the runs taken before
+//it. So only the player's third runs of each length and the opponent's last
+//run taken are needed, which the start masks give directly.
+template<typename BoardType>
+void BasicRunTracker<BoardType>::scored_runs(PlayerColor player, std::array<int, 3>& player_runs,
+        std::array<int, 3>& opponent_runs) const
+{
+    const int AREA = SIZE*SIZE;
+    const int NEVER = 4*AREA;
+
+    PlayerColor opponent = opposing_color(player);
+    best_runs(player, player_runs.data(), 3);
+
+    //For each length, the time from which the opponent's runs are left out,
+    //and the number of the opponent's runs taken.
+    int cutoff[MAX_RUN+1];
+    int taken[MAX_RUN+1];
+    for(int len = 1; len <= MAX_RUN; ++len) {
+        cutoff[len] = NEVER;
+        taken[len] = (m_runs[opponent] >> ((len-1)*16)) & 0xFFFF;
+    }
+
+    Mask at_least[4] = {};
+    for(int len = MAX_RUN; len > 0; --len) {
+        int needed = 3;
+        for(int direction = 0; direction < 4; ++direction) {
+            at_least[direction] |= m_run_starts[direction][player][len];
+            int count = BoardType::count_entries(at_least[direction]);
+            if(count < needed) {
+                needed -= count;
+                continue;
+            }
+
+            Mask third = at_least[direction];
+            for(int i = 1; i < needed; ++i) {
+                third &= third - 1;
+            }
+            int position = BoardType::lowest_entry(third);
+            cutoff[len] = direction*AREA + position;
+
+            Mask before = (Mask(1) << position) - 1;
+            taken[len] = BoardType::count_entries(m_run_starts[direction][opponent][len] & before);
+            for(int earlier = 0; earlier < direction; ++earlier) {
+                taken[len] += BoardType::count_entries(m_run_starts[earlier][opponent][len]);
+            }
+            //at_least of later directions is no longer complete, but every
+            //shorter length has an earlier cutoff, so they are not read.
+            break;
+        }
+    }
+
+    //The opponent's last run taken.
+    int last_len = 0;
+    int last_time = -1;
+    for(int len = 1; len <= MAX_RUN; ++len) {
+        if(taken[len] == 0) {
+            continue;
+        }
+        for(int direction = std::min(cutoff[len] / AREA, 3); direction >= 0; --direction) {
+            Mask starts = m_run_starts[direction][opponent][len];
+            if(direction*AREA + AREA > cutoff[len]) {
+                starts &= (Mask(1) << (cutoff[len] - direction*AREA)) - 1;
+            }
+            if(starts) {
+                int time = direction*AREA + highest_position(starts);
+                if(time > last_time) {
+                    last_time = time;
+                    last_len = len;
+                }
+                break;
+            }
+        }
+    }
+
+    opponent_runs.fill(0);
+    if(last_len == 0) {
+        return;
+    }
+
+    //The top two taken before the last.
+    taken[last_len] -= 1;
+    int before[2] = {0, 0};
+    for(int len = MAX_RUN, found = 0; len > 0 && found < 2; --len) {
+        for(int i = 0; i < taken[len] && found < 2; ++i) {
+            before[found++] = len;
+        }
+    }
+
+    opponent_runs[0] = std::max(before[0], last_len);
+    opponent_runs[1] = std::max(before[1], std::min(before[0], last_len));
+    opponent_runs[2] = std::min(before[1], last_len);
+}
+
+template class BasicRunTracker<Board>;
+template class BasicRunTracker<LargeBoard>;
@@ -0,0 +1,123 @@
+#ifndef RUNTRACKER_H__
+#define RUNTRACKER_H__
+
+#include <array>
+#include <cstdint>
+
+#include "Board.h"
+
+//The runs scored by the minimax evaluation, kept up to date as moves are made
+//and unmade instead of rescanning the board for every score.
+//
+//A run is what the evaluation scans from each stone in each of four
+//directions (right, down, down-right and up-right): the number of stones of
+//the same color among the next WIN_SIZE-1 entries, up to the first opposing
+//stone. Scans never leave the row, column or diagonal they start on, so the
+//runs of a line only depend on its contents. The tracker keeps each line as
+//a base 3 pattern index and looks its runs up in a table built at compile
+//time, and an update only touches the lines through entries that changed
+//since the last one. That includes the threats the evaluation scores, runs of WIN_SIZE-1.
+template<typename BoardType>
+class BasicRunTracker
+{
+public:
+    BasicRunTracker();
+    explicit BasicRunTracker(const BoardType& board);
+
+    //Count the runs of every line of board.
+    void reset(const BoardType& board);
+
+    //Bring the counts up to date with board, typically after a move was made
+    //or unmade on it. Costs in proportion to the entries that changed.
+    void update(const BoardType& board);
+
+    //Write the count longest runs of color's stones to runs, longest first
+    //and padded with zeros.
+    void best_runs(PlayerColor color, int* runs, int count) const;
+
+    //Write the runs the minimax evaluation scores for player and for the
+    //opponent, as its scan of the board picks them. The scan visits the run
+    //from every stone, rows first, then columns, diagonals and anti-diagonals,
+    //each stone by stone row by row. It keeps the top 3 runs of each color,
+    //but only takes a run while it is longer than the player's third best so
+    //far, and an opponent's run too short for the opponent's top 3 still
+    //replaces the third. player_runs are the player's top 3; opponent_runs
+    //depend on the scan order.
+    void scored_runs(PlayerColor player, std::array<int, 3>& player_runs,
+            std::array<int, 3>& opponent_runs) const;
+
+private:
+    typedef typename BoardType::Mask Mask;
+
+    static constexpr int SIZE = BoardType::BOARD_SIZE;
+    static constexpr int LINE_COUNT = 6*SIZE - 2;
+    static constexpr int MAX_RUN = BoardType::WIN_SIZE - 1;
+    static constexpr int PATTERN_COUNT = power_of_three(SIZE);
+
+    static_assert(LINE_COUNT <= 64, "lines to update are kept in a 64 bit mask");
+    static_assert(MAX_RUN <= 4, "run counts are packed in four 16 bit lanes");
+
+    //Bits per place of a pattern's runs: the length of the run from the
+    //place, and above it whether the stone there is black.
+    static constexpr int PLACE_BITS = 4;
+    static constexpr int BLACK_PLACE_BIT = 8;
+    static_assert(SIZE*PLACE_BITS <= 64, "runs of a line are packed in 64 bits");
+
+    //The runs of one color by length, with the count of runs of length len
+    //in the 16 bits from (len-1)*16. Lanes never carry, so packed counts are
+    //added and subtracted as plain integers.
+    typedef std::uint64_t PackedRuns;
+
+    //Every lookup table the tracker uses, built at compile time by
+    //build_tables().
+    struct Tables
+    {
+        //The line through each entry in each direction, and the place value
+        //of the entry's digit in the line's pattern.
+        std::uint8_t entry_line[BoardType::TOTAL_ENTRIES][4];
+        std::uint16_t entry_digit[BoardType::TOTAL_ENTRIES][4];
+
+        //The direction of each line, and its absolute positions
+        //(x + y*SIZE) by place along it.
+        std::uint8_t line_direction[LINE_COUNT];
+        std::uint8_t line_position[LINE_COUNT][SIZE];
+
+        //The runs of each color by line pattern. A pattern has a base 3
+        //digit per entry in scan order, with BoardEntry values as digits.
+        //Lines shorter than SIZE leave their top digits empty, which adds
+        //no runs.
+        PackedRuns pattern_runs[PATTERN_COUNT][2];
+
+        //The run from each place of each pattern, PLACE_BITS bits per place.
+        std::uint64_t pattern_places[PATTERN_COUNT];
+    };
+
+    static constexpr Tables build_tables();
+    static constexpr void add_line(Tables& tables, int line_index, int x, int y,
+            int dx, int dy, int direction);
+
+    static const Tables s_tables;
+
+    static int highest_position(Mask mask);
+
+    //The board as of the last update.
+    Mask m_white_mask;
+    Mask m_black_mask;
+
+    //Pattern of each line, and the runs of each color over all lines.
+    std::array<std::uint16_t, LINE_COUNT> m_patterns;
+    PackedRuns m_runs[2];
+
+    //The stones runs start from, by absolute position, for each direction,
+    //color and length. Bit order is the order the evaluation scans them in.
+    //Length 0 collects places without a run, so updates need no branches,
+    //and is never read.
+    Mask m_run_starts[4][2][MAX_RUN+1];
+};
+
+typedef BasicRunTracker<Board> RunTracker;
+
+extern template class BasicRunTracker<Board>;
+extern template class BasicRunTracker<LargeBoard>;
+
+#endif
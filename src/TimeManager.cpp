@@ -0,0 +1,71 @@
+#include "TimeManager.h"
+
+#include <algorithm>
+
+//Without a game clock, the soft budget is this part of the move limit, so a
+//depth that is unlikely to finish is not started.
+static const double SOFT_FRACTION = 0.5;
+
+//With a game clock, the hard budget is at most this many times a move's even
+//share of the time left, and never more than this part of the time left.
+static const double HARD_SHARE = 3.0;
+static const double MAX_TIME_LEFT_FRACTION = 0.5;
+
+//Factor on the soft budget for each depth that changes the best move, the
+//factor it decays by for each depth that does not, and its cap.
+static const double INSTABILITY_GROWTH = 1.5;
+static const double INSTABILITY_DECAY = 0.75;
+static const double MAX_INSTABILITY = 2.0;
+
+TimeManager::TimeManager(double max_move_time, double game_time):
+    m_max_move_time(max_move_time), m_game_time(game_time), m_game_time_used(0.0),
+    m_move_start(Clock::now()), m_soft_budget(max_move_time*SOFT_FRACTION),
+    m_hard_budget(max_move_time), m_instability(1.0)
+{
+}
+
+void TimeManager::start_move(int moves_left)
+{
+    m_move_start = Clock::now();
+    m_instability = 1.0;
+
+    m_hard_budget = m_max_move_time;
+    m_soft_budget = m_max_move_time*SOFT_FRACTION;
+    if(m_game_time > 0.0) {
+        double time_left = std::max(game_time_left(), 0.0);
+        double share = time_left / std::max(moves_left, 1);
+        m_hard_budget = std::min(m_hard_budget,
+                std::min(share*HARD_SHARE, time_left*MAX_TIME_LEFT_FRACTION));
+        m_soft_budget = std::min(std::min(m_soft_budget, share), m_hard_budget);
+    }
+}
+
+void TimeManager::end_move()
+{
+    m_game_time_used += elapsed_seconds();
+}
+
+//The soft budget never stretches past the hard one.
+void TimeManager::iteration_done(bool best_move_changed)
+{
+    if(best_move_changed) {
+        m_instability = std::min(m_instability*INSTABILITY_GROWTH, MAX_INSTABILITY);
+    } else {
+        m_instability = std::max(m_instability*INSTABILITY_DECAY, 1.0);
+    }
+    m_instability = std::min(m_instability, m_hard_budget / std::max(m_soft_budget, 1e-9));
+}
+
+double TimeManager::elapsed_seconds() const
+{
+    return std::chrono::duration<double>(Clock::now() - m_move_start).count();
+}
+
+bool TimeManager::check_deadline(int& countdown) const
+{
+    if(--countdown > 0) {
+        return false;
+    }
+    countdown = CHECK_INTERVAL;
+    return elapsed_seconds() >= m_hard_budget;
+}
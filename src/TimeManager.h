@@ -0,0 +1,62 @@
+#ifndef TIMEMANAGER_H__
+#define TIMEMANAGER_H__
+
+#include <chrono>
+
+//Decides how long the search of a move may run, from a limit per move and
+//optionally a clock for the whole game, on the monotonic wall clock.
+//
+//Each move gets a soft and a hard budget. Iterative deepening does not start
+//another depth once the soft budget is spent, and the search is cancelled at
+//the hard one. The soft budget stretches while the best move keeps changing
+//between depths, and shrinks back once it settles.
+//
+//Reading the clock costs about as much as searching a node, so searches ask
+//through check_deadline with a countdown of their own, which only reads the
+//clock every CHECK_INTERVAL calls.
+class TimeManager
+{
+public:
+    typedef std::chrono::steady_clock Clock;
+
+    static const int CHECK_INTERVAL = 1024;
+
+    //max_move_time caps every move. A positive game_time is the time for all
+    //of the owner's moves in the game, shared out over the moves left.
+    explicit TimeManager(double max_move_time, double game_time = 0.0);
+
+    //Start timing a move, given an estimate of the owner's moves left in the
+    //game counting this one.
+    void start_move(int moves_left);
+
+    //Stop timing the move and charge it to the game clock.
+    void end_move();
+
+    //Note a completed depth, and whether it changed the best move.
+    void iteration_done(bool best_move_changed);
+
+    double elapsed_seconds() const;
+    double soft_budget() const {return m_soft_budget*m_instability;}
+    double hard_budget() const {return m_hard_budget;}
+
+    bool soft_limit_reached() const {return elapsed_seconds() >= soft_budget();}
+
+    //Whether the hard budget is spent, reading the clock only when countdown,
+    //which belongs to the caller, runs out.
+    bool check_deadline(int& countdown) const;
+
+    //Time left on the game clock, if there is one.
+    double game_time_left() const {return m_game_time - m_game_time_used;}
+
+private:
+    double m_max_move_time;
+    double m_game_time;
+    double m_game_time_used;
+
+    Clock::time_point m_move_start;
+    double m_soft_budget;
+    double m_hard_budget;
+    double m_instability;
+};
+
+#endif
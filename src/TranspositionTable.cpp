@@ -0,0 +1,40 @@
+#include "TranspositionTable.h"
+
+TranspositionTable::TranspositionTable(std::size_t size_mb):
+    m_entry_count(0), m_index_mask(0), m_generation(0)
+{
+    resize(size_mb);
+}
+
+//Use the largest power of two entries that fits, so a slot is found by
+//masking the hash.
+void TranspositionTable::resize(std::size_t size_mb)
+{
+    std::size_t max_entries = size_mb * 1024 * 1024 / sizeof(Slot);
+    std::size_t entries = 1;
+    while(entries * 2 <= max_entries) {
+        entries *= 2;
+    }
+
+    m_slots.reset(new Slot[entries]);
+    m_entry_count = entries;
+    m_index_mask = entries - 1;
+    clear();
+}
+ 
+//An empty slot has a negative depth, so it never reads as a hit.
+void TranspositionTable::clear()
+{
+    Entry empty;
+    empty.score = 0.0;
+    empty.best_move = PackedMove::invalid_move();
+    empty.depth = -1;
+    empty.bound = ExactBound;
+    empty.generation = 0;
+    std::uint64_t data = pack(empty);
+
+    for(std::size_t i = 0; i < m_entry_count; ++i) {
+        m_slots[i].check.store(data, std::memory_order_relaxed);
+        m_slots[i].data.store(data, std::memory_order_relaxed);
+    }
+}
@@ -0,0 +1,143 @@
+#ifndef TRANSPOSITIONTABLE_H__
+#define TRANSPOSITIONTABLE_H__
+
+#include <cstdint>
+#include <cstddef>
+#include <cstring>
+#include <atomic>
+#include <memory>
+
+#include "Move.h"
+
+//A fixed size table of search results, indexed by the Zobrist hash of the
+//position. Every hash maps to a single slot. A new result replaces the stored
+//one unless the stored one is from the current search and was searched
+//deeper (depth-preferred replacement).
+//
+//The table can be shared by several search threads without locking. A slot
+//holds the packed result and the hash xor the packed result, so a slot torn
+//by concurrent writes fails the hash check and reads as a miss.
+class TranspositionTable
+{
+public:
+    //How a stored score relates to the true value of the position.
+    enum Bound {
+        ExactBound,
+        LowerBound,
+        UpperBound
+    };
+
+    struct Entry
+    {
+        float score;
+        PackedMove best_move;
+        int depth;
+        Bound bound;
+        int generation;
+    };
+
+    //Construct a table using about size_mb megabytes.
+    explicit TranspositionTable(std::size_t size_mb);
+    ~TranspositionTable() {};
+
+    void resize(std::size_t size_mb);
+    void clear();
+
+    //Start a new search. Entries from earlier searches can still be probed,
+    //but are replaced regardless of depth.
+    void new_search() {m_generation = (m_generation + 1) & GENERATION_MASK;}
+
+    //Copy the entry for hash to entry and return true, or return false if
+    //the table holds nothing for hash.
+    bool probe(std::uint64_t hash, Entry& entry) const;
+
+    void store(std::uint64_t hash, int depth, Bound bound, float score, PackedMove best_move);
+
+    std::size_t entry_count() const {return m_entry_count;}
+
+private:
+    static const int GENERATION_MASK = 0x3F;
+
+    struct Slot
+    {
+        std::atomic<std::uint64_t> check;
+        std::atomic<std::uint64_t> data;
+    };
+
+    //The packed result: score in bits 0-31, best move in bits 32-47, depth
+    //in bits 48-55, bound in bits 56-57 and generation in bits 58-63.
+    static std::uint64_t pack(const Entry& entry);
+    static Entry unpack(std::uint64_t data);
+
+    std::unique_ptr<Slot[]> m_slots;
+    std::size_t m_entry_count;
+    std::uint64_t m_index_mask;
+    int m_generation;
+};
+
+
+inline std::uint64_t TranspositionTable::pack(const Entry& entry)
+{
+    std::uint32_t score_bits;
+    std::memcpy(&score_bits, &entry.score, sizeof(score_bits));
+
+    return score_bits | (std::uint64_t(entry.best_move.bits()) << 32) |
+        (std::uint64_t(entry.depth & 0xFF) << 48) | (std::uint64_t(entry.bound) << 56) |
+        (std::uint64_t(entry.generation) << 58);
+}
+
+inline TranspositionTable::Entry TranspositionTable::unpack(std::uint64_t data)
+{
+    Entry entry;
+    std::uint32_t score_bits = static_cast<std::uint32_t>(data);
+    std::memcpy(&entry.score, &score_bits, sizeof(score_bits));
+    entry.best_move = PackedMove::from_bits(static_cast<std::uint16_t>(data >> 32));
+    entry.depth = static_cast<std::int8_t>(data >> 48);
+    entry.bound = static_cast<Bound>((data >> 56) & 3);
+    entry.generation = static_cast<int>(data >> 58);
+    return entry;
+}
+
+inline bool TranspositionTable::probe(std::uint64_t hash, Entry& entry) const
+{
+    const Slot& slot = m_slots[hash & m_index_mask];
+    std::uint64_t data = slot.data.load(std::memory_order_relaxed);
+    std::uint64_t check = slot.check.load(std::memory_order_relaxed);
+    if((check ^ data) != hash) {
+        return false;
+    }
+
+    entry = unpack(data);
+    return entry.depth >= 0;
+}
+
+inline void TranspositionTable::store(std::uint64_t hash, int depth, Bound bound, float score,
+        PackedMove best_move)
+{
+    Slot& slot = m_slots[hash & m_index_mask];
+    std::uint64_t old_data = slot.data.load(std::memory_order_relaxed);
+    bool same_position = (slot.check.load(std::memory_order_relaxed) ^ old_data) == hash;
+    Entry old_entry = unpack(old_data);
+
+    if(old_entry.depth > depth && old_entry.generation == m_generation) {
+        return;
+    }
+
+    //Keep the best move of a position that is searched again without one.
+    if(best_move.is_invalid() && same_position && old_entry.depth >= 0) {
+        best_move = old_entry.best_move;
+    }
+
+    Entry entry;
+    entry.score = score;
+    entry.best_move = best_move;
+    entry.depth = depth;
+    entry.bound = bound;
+    entry.generation = m_generation;
+
+    std::uint64_t data = pack(entry);
+    slot.check.store(hash ^ data, std::memory_order_relaxed);
+    slot.data.store(data, std::memory_order_relaxed);
+}
+
+#endif
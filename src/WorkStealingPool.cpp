@@ -0,0 +1,75 @@
+#include "WorkStealingPool.h"
+
+#include <algorithm>
+
+WorkStealingPool::WorkStealingPool(int thread_count):
+    m_thread_count(std::max(thread_count, 1)), m_queues(new TaskQueue[m_thread_count]),
+    m_stop(false)
+{
+    for(int i = 1; i < m_thread_count; ++i) {
+        m_threads.push_back(std::thread(&WorkStealingPool::worker, this, i));
+    }
+}
+
+//Tasks still queued are dropped. Owners are expected to wait for their tasks
+//before the pool goes away.
+WorkStealingPool::~WorkStealingPool()
+{
+    m_stop = true;
+    for(std::thread& thread : m_threads) {
+        thread.join();
+    }
+}
+
+void WorkStealingPool::push(int thread_index, Task task)
+{
+    TaskQueue& queue = m_queues[thread_index];
+    std::lock_guard<std::mutex> lock(queue.mutex);
+    queue.tasks.push_back(std::move(task));
+}
+
+bool WorkStealingPool::run_task(int thread_index)
+{
+    Task task;
+    if(!pop(thread_index, task) && !steal(thread_index, task)) {
+        return false;
+    }
+    task(thread_index);
+    return true;
+}
+
+bool WorkStealingPool::pop(int thread_index, Task& task)
+{
+    TaskQueue& queue = m_queues[thread_index];
+    std::lock_guard<std::mutex> lock(queue.mutex);
+    if(queue.tasks.empty()) {
+        return false;
+    }
+    task = std::move(queue.tasks.back());
+    queue.tasks.pop_back();
+    return true;
+}
+
+//Try the other queues in turn, starting after the thief's own.
+bool WorkStealingPool::steal(int thread_index, Task& task)
+{
+    for(int i = 1; i < m_thread_count; ++i) {
+        TaskQueue& queue = m_queues[(thread_index + i) % m_thread_count];
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        if(!queue.tasks.empty()) {
+            task = std::move(queue.tasks.front());
+            queue.tasks.pop_front();
+            return true;
+        }
+    }
+    return false;
+}
+
+void WorkStealingPool::worker(int thread_index)
+{
+    while(!m_stop) {
+        if(!run_task(thread_index)) {
+            std::this_thread::yield();
+        }
+    }
+}
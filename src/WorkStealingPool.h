@@ -0,0 +1,55 @@
+#ifndef WORKSTEALINGPOOL_H__
+#define WORKSTEALINGPOOL_H__
+
+#include <functional>
+#include <deque>
+#include <vector>
+#include <mutex>
+#include <thread>
+#include <atomic>
+#include <memory>
+
+//A pool of threads with a task queue per thread. A thread runs tasks from the
+//back of its own queue, and steals from the front of the other queues when its
+//own is empty, so thieves take the oldest, and usually largest, tasks.
+//
+//Thread 0 is the thread that owns the pool. The pool only starts the others;
+//thread 0 runs tasks through run_task, typically while it waits for tasks it
+//pushed to finish.
+class WorkStealingPool
+{
+public:
+    //Tasks are called with the index of the thread running them.
+    typedef std::function<void(int)> Task;
+
+    explicit WorkStealingPool(int thread_count);
+    ~WorkStealingPool();
+
+    int thread_count() const {return m_thread_count;}
+
+    //Add a task to the queue of thread thread_index.
+    void push(int thread_index, Task task);
+
+    //Run one task, from thread thread_index's own queue if it has one or
+    //stolen from another queue otherwise. Returns false if every queue was
+    //empty.
+    bool run_task(int thread_index);
+
+private:
+    struct TaskQueue
+    {
+        std::mutex mutex;
+        std::deque<Task> tasks;
+    };
+
+    bool pop(int thread_index, Task& task);
+    bool steal(int thread_index, Task& task);
+    void worker(int thread_index);
+
+    int m_thread_count;
+    std::unique_ptr<TaskQueue[]> m_queues;
+    std::vector<std::thread> m_threads;
+    std::atomic<bool> m_stop;
+};
+
+#endif
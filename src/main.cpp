@@ -77,8 +77,10 @@ std::unique_ptr<ControllerFactory> initialize_controller_factory() {
 
     factory->register_constructor("Computer (Minimax) Controlled", 
         [](std::string name, PlayerColor color, const Board& initial_board) -> PlayerController* {
-            return new MinimaxComputerController(std::move(name), color, initial_board,
-                4, 15.00);
+            auto controller = new MinimaxComputerController(std::move(name), color,
+                initial_board, 4, 15.00);
+            controller->set_pondering(true);
+            return controller;
         });
 
     return factory;